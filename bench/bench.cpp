@@ -0,0 +1,203 @@
+//
+// Created by jay on 8/1/23.
+//
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <string_view>
+#include "util.hpp"
+#include "generators.hpp"
+#include "graph/ts.hpp"
+#include "graph/graph_reader.hpp"
+#include "checker/checker.hpp"
+
+using namespace ctl;
+using clk = std::chrono::steady_clock;
+
+namespace {
+struct options {
+  double scale = 1.0;
+  size_t repeat = 3;
+  size_t threads = 1;
+  size_t dense_max = 20000;
+  std::vector<double> densities = { 0.7, 0.05, 0.5 };
+  std::string filter;
+  const char *out = nullptr;
+};
+
+struct result {
+  std::string model;
+  std::string params;
+  size_t states;
+  size_t edges;
+  std::string backend;
+  std::string op;
+  std::vector<double> ms;
+};
+
+// Runs f `repeat` times and returns the wall time of every run (in ms). f returns something that depends on the
+// work done (e.g. a set size), which is accumulated so the compiler can't drop the work.
+volatile size_t sink = 0;
+std::vector<double> measure(size_t repeat, const std::function<size_t()> &f) {
+  std::vector<double> res;
+  for(size_t r = 0; r < repeat; r++) {
+    auto start = clk::now();
+    sink = sink + f();
+    res.push_back(std::chrono::duration<double, std::milli>(clk::now() - start).count());
+  }
+  return res;
+}
+
+std::string json_escape(const std::string &s) {
+  std::string res;
+  for(const char c: s) {
+    if(c == '"' || c == '\\') res += '\\';
+    res += c;
+  }
+  return res;
+}
+
+void write_json(std::ostream &out, const std::vector<result> &results, const options &opts) {
+  out << std::setprecision(6) << "{\n  \"scale\": " << opts.scale << ",\n  \"repeat\": " << opts.repeat
+      << ",\n  \"threads\": " << opts.threads << ",\n  \"results\": [\n";
+  for(size_t k = 0; k < results.size(); k++) {
+    const auto &r = results[k];
+    auto sorted = r.ms;
+    std::sort(sorted.begin(), sorted.end());
+    out << "    { \"model\": \"" << r.model << "\", \"params\": \"" << json_escape(r.params) << "\", \"states\": "
+        << r.states << ", \"edges\": " << r.edges << ", \"backend\": \"" << r.backend << "\", \"op\": \"" << r.op
+        << "\", \"min_ms\": " << sorted.front() << ", \"median_ms\": " << sorted[sorted.size() / 2] << ", \"runs_ms\": [";
+    for(size_t i = 0; i < r.ms.size(); i++) out << (i == 0 ? "" : ", ") << r.ms[i];
+    out << "] }" << (k + 1 == results.size() ? "" : ",") << "\n";
+  }
+  out << "  ]\n}\n";
+}
+
+class runner {
+public:
+  explicit runner(const options &opts) : opts{opts} {}
+
+  void run(const bench::model &m) {
+    if(!opts.filter.empty() && m.name().find(opts.filter) == std::string::npos) return;
+    std::cerr << m.name() << ": " << m.states << " states, " << m.edges.size() << " edges\n";
+
+    const std::string text = bench::to_gts(m);
+    record(m, "sparse", "parse", [&text]() {
+      std::istringstream strm(text);
+      return graph::graph_reader::parse(strm).size();
+    });
+    const auto path = std::filesystem::temp_directory_path() / "ctl_bench.gts";
+    std::ofstream(path) << text;
+    record(m, "sparse", "parse_file", [this, &path]() {
+      return graph::graph_reader::parse_file(path.string(), opts.threads).size();
+    });
+    std::filesystem::remove(path);
+
+    operators<graph::sparse_ts>(m, "sparse");
+    if(m.states <= opts.dense_max) operators<graph::dense_ts>(m, "dense");
+    else std::cerr << "  (dense backend skipped: more than " << opts.dense_max << " states)\n";
+  }
+
+  [[nodiscard]] inline const std::vector<result> &results() const { return all; }
+
+private:
+  template <graph::TS T>
+  void operators(const bench::model &m, const std::string &backend) {
+    record(m, backend, "build", [&m]() { return bench::build<T>(m).size(); });
+    const T ts = bench::build<T>(m);
+
+    checker::sat_calc calc(opts.threads);
+    using set_t = checker::sat_calc::set_t;
+    const set_t p0 = calc.sat_atom("p0", ts);
+    const set_t p1 = calc.sat_atom("p1", ts);
+
+    record(m, backend, "sat_atom", [&]() { return calc.sat_atom("p0", ts).count(); });
+    record(m, backend, "sat_negation", [&]() { return calc.sat_negation(p0).count(); });
+    record(m, backend, "sat_conjunction", [&]() { return calc.sat_conjunction(p0, p1).count(); });
+    record(m, backend, "sat_e_next", [&]() { return calc.sat_e_next(p1, ts).count(); });
+    record(m, backend, "sat_e_until", [&]() { return calc.sat_e_until(p0, p1, ts).count(); });
+    calc.eg = checker::sat_calc::eg_engine::COUNTING;
+    record(m, backend, "sat_e_always", [&]() { return calc.sat_e_always(p0, ts).count(); });
+    calc.eg = checker::sat_calc::eg_engine::SCC;
+    record(m, backend, "sat_e_always_scc", [&]() { return calc.sat_e_always(p0, ts).count(); });
+    record(m, backend, "sat_e_future", [&]() { return calc.sat_e_future(p1, ts).count(); });
+    record(m, backend, "sat_a_next", [&]() { return calc.sat_a_next(p1, ts).count(); });
+    record(m, backend, "sat_a_until", [&]() { return calc.sat_a_until(p0, p1, ts).count(); });
+    record(m, backend, "sat_a_always", [&]() { return calc.sat_a_always(p0, ts).count(); });
+    record(m, backend, "sat_a_future", [&]() { return calc.sat_a_future(p1, ts).count(); });
+  }
+
+  void record(const bench::model &m, const std::string &backend, const std::string &op, const std::function<size_t()> &f) {
+    auto ms = measure(opts.repeat, f);
+    std::cerr << "  " << std::left << std::setw(7) << backend << std::setw(18) << op << std::right << std::fixed
+              << std::setprecision(3) << std::setw(12) << *std::min_element(ms.begin(), ms.end()) << " ms\n";
+    all.push_back({ m.family, m.params, m.states, m.edges.size(), backend, op, std::move(ms) });
+  }
+
+  const options &opts;
+  std::vector<result> all;
+};
+
+std::vector<double> parse_densities(const std::string &s) {
+  std::vector<double> res;
+  for(const auto &part: split_by(s, ',')) res.push_back(std::strtod(part.c_str(), nullptr));
+  return res;
+}
+}
+
+int main(int argc, const char **argv) {
+  options opts;
+  for(int i = 1; i < argc; i++) {
+    std::string_view arg = argv[i];
+    if(arg == "--scale" && i + 1 < argc) opts.scale = std::strtod(argv[++i], nullptr);
+    else if(arg == "--repeat" && i + 1 < argc) opts.repeat = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+    else if(arg == "--threads" && i + 1 < argc) opts.threads = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+    else if(arg == "--dense-max" && i + 1 < argc) opts.dense_max = std::strtoul(argv[++i], nullptr, 10);
+    else if(arg == "--densities" && i + 1 < argc) opts.densities = parse_densities(argv[++i]);
+    else if(arg == "--filter" && i + 1 < argc) opts.filter = argv[++i];
+    else if(arg == "--out" && i + 1 < argc) opts.out = argv[++i];
+    else {
+      std::cerr << "Usage: " << argv[0] << " [--scale <f>] [--repeat <n>] [--threads <n>] [--dense-max <states>]\n"
+                << "       [--densities <d0,d1,...>] [--filter <substring of model name>] [--out <json file>]\n";
+      return -1;
+    }
+  }
+  // the operators use p0 and p1
+  while(opts.densities.size() < 2) opts.densities.push_back(0.5);
+
+  auto sized = [&opts](double n) { return std::max<size_t>(1, (size_t)(n * opts.scale)); };
+  std::mt19937_64 rng(42);
+  std::vector<bench::model> models;
+  models.push_back(bench::random_gnp(sized(100000), 4.0 / (double)sized(100000), rng));
+  models.push_back(bench::random_gnp(sized(5000), 0.01, rng));
+  models.push_back(bench::power_law(sized(100000), 3, rng));
+  models.push_back(bench::grid(sized(300), 300));
+  models.push_back(bench::chain(sized(200000)));
+  models.push_back(bench::clique(sized(400)));
+  models.push_back(bench::nested_sccs(4, 6, sized(60)));
+
+  runner r(opts);
+  for(auto &m: models) {
+    bench::add_labels(m, opts.densities, rng);
+    r.run(m);
+  }
+
+  if(opts.out != nullptr) {
+    std::ofstream out(opts.out);
+    write_json(out, r.results(), opts);
+    if(!out.good()) {
+      std::cerr << "Error: can't write " << opts.out << "\n";
+      return -2;
+    }
+  }
+  else {
+    write_json(std::cout, r.results(), opts);
+  }
+  return 0;
+}
@@ -0,0 +1,134 @@
+//
+// Created by jay on 8/1/23.
+//
+
+#include <sstream>
+#include <algorithm>
+#include "generators.hpp"
+
+using namespace ctl;
+using namespace ctl::bench;
+
+namespace {
+std::string fmt(double v) {
+  std::ostringstream buf;
+  buf << v;
+  return buf.str();
+}
+}
+
+model bench::random_gnp(size_t n, double p, std::mt19937_64 &rng) {
+  model res{ "gnp", "n=" + std::to_string(n) + ",p=" + fmt(p), n };
+  if(p <= 0 || n == 0) return res;
+  // skip over the non-edges with geometrically distributed gaps instead of flipping a coin for every pair
+  std::geometric_distribution<size_t> gap(std::min(p, 1.0));
+  const size_t pairs = n * n;
+  for(size_t k = p >= 1 ? 0 : gap(rng); k < pairs; k += 1 + (p >= 1 ? 0 : gap(rng))) {
+    res.edges.emplace_back(k / n, k % n);
+  }
+  return res;
+}
+
+model bench::power_law(size_t n, size_t m, std::mt19937_64 &rng) {
+  model res{ "power_law", "n=" + std::to_string(n) + ",m=" + std::to_string(m), n };
+  // every state appears in `ends` once per incident edge (plus once, so fresh states can be picked)
+  std::vector<size_t> ends;
+  std::bernoulli_distribution forward(0.5);
+  for(size_t v = 0; v < n; v++) {
+    std::unordered_set<size_t> picked;
+    for(size_t k = 0; k < m && k < v; k++) {
+      const size_t u = ends[std::uniform_int_distribution<size_t>(0, ends.size() - 1)(rng)];
+      if(!picked.insert(u).second) continue;
+      if(forward(rng)) res.edges.emplace_back(v, u);
+      else res.edges.emplace_back(u, v);
+      ends.push_back(u);
+      ends.push_back(v);
+    }
+    ends.push_back(v);
+  }
+  return res;
+}
+
+model bench::grid(size_t w, size_t h) {
+  model res{ "grid", "w=" + std::to_string(w) + ",h=" + std::to_string(h), w * h };
+  for(size_t y = 0; y < h; y++) {
+    for(size_t x = 0; x < w; x++) {
+      const size_t s = y * w + x;
+      if(x + 1 < w) {
+        res.edges.emplace_back(s, s + 1);
+        res.edges.emplace_back(s + 1, s);
+      }
+      if(y + 1 < h) {
+        res.edges.emplace_back(s, s + w);
+        res.edges.emplace_back(s + w, s);
+      }
+    }
+  }
+  return res;
+}
+
+model bench::chain(size_t n) {
+  model res{ "chain", "n=" + std::to_string(n), n };
+  for(size_t s = 0; s + 1 < n; s++) res.edges.emplace_back(s, s + 1);
+  if(n > 0) res.edges.emplace_back(n - 1, n - 1);
+  return res;
+}
+
+model bench::clique(size_t n) {
+  model res{ "clique", "n=" + std::to_string(n), n };
+  res.edges.reserve(n * n);
+  for(size_t s = 0; s < n; s++) {
+    for(size_t t = 0; t < n; t++) res.edges.emplace_back(s, t);
+  }
+  return res;
+}
+
+model bench::nested_sccs(size_t levels, size_t fanout, size_t ring) {
+  model res{ "nested_sccs", "levels=" + std::to_string(levels) + ",fanout=" + std::to_string(fanout) + ",ring=" +
+                            std::to_string(ring) };
+  // a component is described by its entry and exit state; states are numbered in creation order
+  struct component { size_t entry, exit; };
+  auto make = [&res, fanout, ring](auto &&self, size_t level) -> component {
+    if(level == 0) {
+      const size_t first = res.states;
+      res.states += ring;
+      for(size_t k = 0; k < ring; k++) res.edges.emplace_back(first + k, first + (k + 1) % ring);
+      return { first, first + ring - 1 };
+    }
+    std::vector<component> parts;
+    for(size_t k = 0; k < fanout; k++) parts.push_back(self(self, level - 1));
+    for(size_t k = 0; k + 1 < fanout; k++) res.edges.emplace_back(parts[k].exit, parts[k + 1].entry);
+    if(level % 2 == 1) res.edges.emplace_back(parts.back().exit, parts.front().entry);
+    return { parts.front().entry, parts.back().exit };
+  };
+  if(ring > 0 && fanout > 0) make(make, levels);
+  return res;
+}
+
+void bench::add_labels(model &m, const std::vector<double> &densities, std::mt19937_64 &rng) {
+  m.labels.assign(densities.size(), {});
+  for(size_t k = 0; k < densities.size(); k++) {
+    std::bernoulli_distribution coin(std::clamp(densities[k], 0.0, 1.0));
+    for(size_t s = 0; s < m.states; s++) {
+      if(coin(rng)) m.labels[k].push_back(s);
+    }
+  }
+}
+
+std::string bench::to_gts(const model &m) {
+  std::vector<std::vector<size_t>> props(m.states);
+  for(size_t k = 0; k < m.labels.size(); k++) {
+    for(const auto s: m.labels[k]) props[s].push_back(k);
+  }
+
+  std::ostringstream out;
+  for(size_t s = 0; s < m.states; s++) {
+    out << "NODE " << (s == 0 ? "INITIAL " : "") << "s" << s << " (";
+    for(size_t k = 0; k < props[s].size(); k++) out << (k == 0 ? "" : ", ") << "p" << props[s][k];
+    // the format needs at least one proposition per node
+    if(props[s].empty()) out << "unlabelled";
+    out << ")\n";
+  }
+  for(const auto &[from, to]: m.edges) out << "TRANS s" << from << " -> s" << to << "\n";
+  return out.str();
+}
@@ -0,0 +1,79 @@
+//
+// Created by jay on 8/1/23.
+//
+
+#ifndef CTL_BENCH_GENERATORS_HPP
+#define CTL_BENCH_GENERATORS_HPP
+
+#include <vector>
+#include <string>
+#include <random>
+#include <utility>
+#include <unordered_set>
+#include "graph/ts.hpp"
+
+namespace ctl::bench {
+/*
+ * A synthetic model, kept as plain edge and label lists so the same model can be written as .gts text and built into
+ * any TS backend. State 0 is the only initial state; proposition k is named p<k>.
+ */
+struct model {
+  inline model(std::string family, std::string params, size_t states = 0)
+    : family{std::move(family)}, params{std::move(params)}, states{states} {}
+
+  std::string family;
+  std::string params;
+  size_t states = 0;
+  std::vector<std::pair<size_t, size_t>> edges;
+  std::vector<std::vector<size_t>> labels; // labels[k]: the states labelled p<k>
+
+  [[nodiscard]] inline std::string name() const { return family + "(" + params + ")"; }
+};
+
+// Erdős–Rényi G(n, p): every ordered pair (i, j) is an edge with probability p.
+model random_gnp(size_t n, double p, std::mt19937_64 &rng);
+// Preferential attachment (Barabási–Albert): every new state links to m earlier ones chosen proportionally to their
+// degree, in a random direction, so in- and out-degrees are power-law distributed.
+model power_law(size_t n, size_t m, std::mt19937_64 &rng);
+// w x h grid with edges between horizontal and vertical neighbours in both directions (one big SCC).
+model grid(size_t w, size_t h);
+// 0 -> 1 -> ... -> n - 1, with a self-loop on the last state: fixpoints need n iterations.
+model chain(size_t n);
+// All n^2 edges, self-loops included.
+model clique(size_t n);
+// Rings of `ring` states, recursively combined: a level-l component is `fanout` level-(l - 1) components in a row,
+// and on odd levels the last one links back to the first, so SCCs nest inside DAGs inside SCCs.
+model nested_sccs(size_t levels, size_t fanout, size_t ring);
+
+// Labels every state with p<k> independently with probability densities[k].
+void add_labels(model &m, const std::vector<double> &densities, std::mt19937_64 &rng);
+std::string to_gts(const model &m);
+
+template <graph::TS T>
+T build(const model &m) {
+  T res;
+  if constexpr(requires { res.reserve(m.states); }) res.reserve(m.states);
+  for(size_t s = 0; s < m.states; s++) {
+    std::string name = "s";
+    name += std::to_string(s);
+    res.add(name, {}, s == 0, false);
+  }
+  for(size_t k = 0; k < m.labels.size(); k++) {
+    std::string name = "p";
+    name += std::to_string(k);
+    const graph::prop p = name;
+    for(const auto s: m.labels[k]) res.add_label(s, p);
+  }
+  if constexpr(requires { res.add_edge(0, 0); }) {
+    res.reserve_edges(m.edges.size());
+    for(const auto &[from, to]: m.edges) res.add_edge(from, to);
+  }
+  else {
+    for(const auto &[from, to]: m.edges) res.add_transition(from, to);
+  }
+  if constexpr(requires { res.freeze(); }) res.freeze();
+  return res;
+}
+}
+
+#endif //CTL_BENCH_GENERATORS_HPP
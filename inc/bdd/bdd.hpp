@@ -0,0 +1,135 @@
+//
+// Created by jay on 7/25/23.
+//
+
+#ifndef CTL_BDD_HPP
+#define CTL_BDD_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace ctl::bdd {
+using var_t = std::uint32_t;
+using ref_t = std::uint32_t;
+
+class manager;
+
+// Reference-counted handle to a BDD node; nodes reachable from a live handle survive garbage collection.
+class bdd {
+public:
+  inline bdd() = default;
+  bdd(manager *mgr, ref_t root);
+  bdd(const bdd &other);
+  bdd(bdd &&other) noexcept;
+  bdd &operator=(const bdd &other);
+  bdd &operator=(bdd &&other) noexcept;
+  ~bdd();
+
+  [[nodiscard]] inline ref_t id() const { return root; }
+  [[nodiscard]] inline manager *owner() const { return mgr; }
+  [[nodiscard]] inline bool is_zero() const { return root == 0; }
+  [[nodiscard]] inline bool is_one() const { return root == 1; }
+  [[nodiscard]] inline bool operator==(const bdd &other) const { return root == other.root; }
+
+  bdd operator&(const bdd &other) const;
+  bdd operator|(const bdd &other) const;
+  bdd operator^(const bdd &other) const;
+  bdd operator!() const;
+  bdd &operator&=(const bdd &other);
+  bdd &operator|=(const bdd &other);
+
+private:
+  manager *mgr = nullptr;
+  ref_t root = 0;
+};
+
+/*
+ * Self-contained ROBDD package with a fixed variable order (the order in which variables are created).
+ * Nodes live in a single table; a hashed unique table guarantees canonicity and a direct-mapped computed cache
+ * memoizes the recursive operations. Unreferenced nodes are reclaimed by a mark-and-sweep garbage collection, which
+ * only ever runs at the start of a top-level operation (never in the middle of a recursion).
+ */
+class manager {
+public:
+  explicit manager(size_t cache_bits = 18);
+  manager(const manager &) = delete;
+  manager &operator=(const manager &) = delete;
+
+  var_t new_var();
+  [[nodiscard]] inline size_t var_count() const { return vars; }
+
+  bdd zero();
+  bdd one();
+  bdd var(var_t v);
+  bdd nvar(var_t v);
+  // Conjunction of the given (positive) variables, as used for quantification.
+  bdd cube(const std::vector<var_t> &vs);
+
+  bdd apply_and(const bdd &f, const bdd &g);
+  bdd apply_or(const bdd &f, const bdd &g);
+  bdd apply_xor(const bdd &f, const bdd &g);
+  bdd negate(const bdd &f);
+  bdd exists(const bdd &f, const bdd &cube);
+  // Relational product: exists cube . (f /\ g), without building f /\ g first.
+  bdd and_exists(const bdd &f, const bdd &g, const bdd &cube);
+  // Renames every variable v in the support of f to map[v]; the renaming must preserve the relative variable order
+  // of the support.
+  bdd replace(const bdd &f, const std::vector<var_t> &map);
+
+  // Number of satisfying assignments over vs (which has to cover the support of f).
+  double sat_count(const bdd &f, const std::vector<var_t> &vs);
+  // Evaluates f under the assignment (indexed by variable).
+  bool eval(const bdd &f, const std::vector<bool> &assignment) const;
+
+  [[nodiscard]] size_t live_nodes() const;
+  void gc();
+
+private:
+  friend bdd;
+  static constexpr var_t terminal = (var_t)-1;
+  static constexpr ref_t nil = (ref_t)-1;
+
+  struct node {
+    var_t var;
+    ref_t low;
+    ref_t high;
+    std::uint32_t refs;
+    ref_t next;
+  };
+
+  enum struct op : std::uint32_t { NONE, AND, OR, XOR, NOT, EXISTS, AND_EXISTS };
+  struct entry {
+    op o = op::NONE;
+    ref_t a = 0, b = 0, c = 0;
+    ref_t res = 0;
+  };
+
+  ref_t mk(var_t v, ref_t low, ref_t high);
+  ref_t and_rec(ref_t f, ref_t g);
+  ref_t or_rec(ref_t f, ref_t g);
+  ref_t xor_rec(ref_t f, ref_t g);
+  ref_t not_rec(ref_t f);
+  ref_t exists_rec(ref_t f, ref_t cube);
+  ref_t and_exists_rec(ref_t f, ref_t g, ref_t cube);
+
+  bool cache_find(op o, ref_t a, ref_t b, ref_t c, ref_t &res) const;
+  void cache_put(op o, ref_t a, ref_t b, ref_t c, ref_t res);
+  void maybe_gc();
+  void rehash();
+
+  inline void ref(ref_t r) { if(r > 1) nodes[r].refs++; }
+  inline void deref(ref_t r) { if(r > 1) nodes[r].refs--; }
+  [[nodiscard]] inline var_t level(ref_t r) const { return nodes[r].var; }
+
+  size_t vars = 0;
+  std::vector<node> nodes;
+  std::vector<ref_t> buckets;
+  ref_t free_list = nil;
+  size_t free_count = 0;
+  size_t gc_threshold;
+  std::vector<entry> cache;
+};
+}
+
+#endif //CTL_BDD_HPP
@@ -5,204 +5,543 @@
 #ifndef CTL_CHECKER_HPP
 #define CTL_CHECKER_HPP
 
-#include <unordered_set>
-#include <unordered_map>
+#include <vector>
 #include <algorithm>
-#include <stack>
+#include <utility>
+#include <memory>
+#include <optional>
+#include <atomic>
+#include <functional>
+#include <cstdint>
 
 #include "formula/formula_parser.hpp"
+#include "formula/formula_dag.hpp"
 #include "graph/ts.hpp"
+#include "graph/state_set.hpp"
+#include "checker/parallel.hpp"
+#include "checker/scc.hpp"
+#include "checker/stats.hpp"
+#include "thread_pool.hpp"
 
 namespace ctl::checker {
 struct sat_calc {
-  template <typename T> using set_t = std::unordered_set<T>;
+  using set_t = graph::state_set;
+  // Algorithm used for E G: successor-count pruning, or SCC decomposition followed by backward reachability.
+  enum struct eg_engine { COUNTING, SCC };
 
-  template <typename T>
-  void set_minus_inplace(set_t<T> &one, const set_t<T> &other) {
-    set_t<T> res;
-    for(const auto &v: one) {
-      if(!other.contains(v)) res.insert(v);
-    }
+  inline sat_calc() = default;
+  // With more than one thread, independent subformulas are evaluated concurrently and the EU and EG fixpoints run on
+  // the frontier-parallel engines.
+  inline explicit sat_calc(size_t threads) : pool{threads > 1 ? std::make_unique<thread_pool>(threads) : nullptr} {}
 
-    res.swap(one);
+  template <graph::TS_view TS>
+  set_t sat_atom(const std::string &atom, const TS &ts) {
+    const size_t n = ts.size();
+    const graph::prop_id id = ts.propositions().find(atom);
+    if(id == graph::prop_table::npos) return set_t(n);
+    return set_t(ts.label(id).words(), n);
   }
 
-  template <typename T>
-  set_t<T> intersect_set(const set_t<T> &one, const set_t<T> &other) {
-    set_t<T> res;
-    for(const auto v: other) {
-      if(one.contains(v)) res.insert(v);
-    }
-    return res;
+  template <graph::TS_view TS>
+  set_t sat_true(const TS &ts) {
+    return set_t(ts.size(), true);
+  }
+
+  set_t sat_negation(set_t s) {
+    s.flip();
+    return s;
+  }
+
+  set_t sat_conjunction(set_t s1, const set_t &s2) {
+    s1 &= s2;
+    return s1;
+  }
+
+  set_t sat_disjunction(set_t s1, const set_t &s2) {
+    s1 |= s2;
+    return s1;
   }
 
-  template <typename T, template <typename> typename C>
-  set_t<const T *> intersect(const set_t<const T *> &one, const C<const T *> &other) {
-    set_t<const T *> res;
-    for(const auto v: other) {
-      if(one.contains(v)) res.insert(v);
+  set_t sat_implication(set_t s1, const set_t &s2) {
+    s1.flip();
+    s1 |= s2;
+    return s1;
+  }
+
+  template <graph::TS_view TS>
+  set_t sat_e_next(const set_t &s1, const TS &ts) {
+    probe pr;
+    if constexpr(graph::image_TS<TS>) {
+      pr.pre();
+      return ts.pre_image(s1);
+    }
+
+    set_t res(ts.size());
+    pr.add_post(ts.size());
+    for(size_t s = 0; s < ts.size(); s++) {
+      if(std::ranges::any_of(ts.successors(s), [&s1, &pr](size_t v){ pr.edge(); return s1.contains(v); })) res.insert(s);
     }
     return res;
   }
 
-  template <graph::TS TS>
-  set_t<const typename TS::node *> sat_atom(const std::string &atom, const TS &ts) {
-    using N = typename TS::node;
-    set_t<const N *> res;
-    for(const N &node: ts.all_nodes()) {
-      const auto &r = node.props();
-      if(r.contains(atom)) res.insert(&node);
+  // A X sub: the states all of whose successors satisfy sub (deadlock states included, as for !EX !sub).
+  template <graph::TS_view TS>
+  set_t sat_a_next(const set_t &sub, const TS &ts) {
+    probe pr;
+    if constexpr(graph::image_TS<TS>) {
+      pr.pre();
+      set_t res = ts.pre_image(~sub);
+      res.flip();
+      return res;
+    }
+
+    set_t res(ts.size());
+    pr.add_post(ts.size());
+    for(size_t s = 0; s < ts.size(); s++) {
+      if(std::ranges::all_of(ts.successors(s), [&sub, &pr](size_t v){ pr.edge(); return sub.contains(v); })) res.insert(s);
     }
     return res;
   }
 
-  template <graph::TS TS>
-  set_t<const typename TS::node *> sat_not_atom(const std::string &atom, const TS &ts) {
-    using N = typename TS::node;
-    set_t<const N *> res;
-    for(const N &node: ts.all_nodes()) {
-      const auto &r = node.props();
-      if(!r.contains(atom)) res.insert(&node);
+  template <graph::TS_view TS>
+  set_t sat_e_until(const set_t &pre, const set_t &post, const TS &ts) {
+    probe pr;
+    if constexpr(graph::image_TS<TS>) {
+      // the whole frontier goes through one image; every state is in the frontier at most once
+      set_t res = post;
+      set_t frontier = post;
+      while(!frontier.empty()) {
+        if(pr.on()) pr.round(frontier.count());
+        pr.pre();
+        frontier = ts.pre_image(frontier) & pre;
+        frontier -= res;
+        res |= frontier;
+      }
+      return res;
     }
+    if(pool) return parallel::e_until(*pool, pre, post, ts);
+
+    set_t res = post;
+    set_t restriction = pre - post;
+
+    std::vector<graph::state_id> frontier{res.begin(), res.end()};
+    std::vector<graph::state_id> next;
+    while(!frontier.empty()) {
+      pr.round(frontier.size());
+      pr.add_pre(frontier.size());
+      for(const auto n: frontier) {
+        for(const size_t p: ts.predecessors(n)) {
+          pr.edge();
+          if(restriction.contains(p)) {
+            restriction.erase(p);
+            res.insert(p);
+            next.push_back(p);
+          }
+        }
+      }
+      frontier.swap(next);
+      next.clear();
+    }
+
     return res;
   }
 
-  template <graph::TS TS>
-  set_t<const typename TS::node *> sat_conjunction(const std::string &a1, const std::string &a2, const TS &ts) {
-    auto s1 = sat_atom(a1, ts);
-    auto s2 = sat_atom(a2, ts);
-    return intersect_set(s1, s2);
-  }
+  // E F sub: E [true U sub] without the restriction, i.e. a single backward search from sub.
+  template <graph::TS_view TS>
+  set_t sat_e_future(const set_t &sub, const TS &ts) {
+    probe pr;
+    if constexpr(graph::image_TS<TS>) {
+      set_t res = sub;
+      set_t frontier = sub;
+      while(!frontier.empty()) {
+        if(pr.on()) pr.round(frontier.count());
+        pr.pre();
+        frontier = ts.pre_image(frontier) - res;
+        res |= frontier;
+      }
+      return res;
+    }
+    if(pool) return parallel::e_until(*pool, sat_true(ts), sub, ts);
 
-  template <graph::TS TS>
-  set_t<const typename TS::node *> sat_e_next(const std::string &next, const TS &ts) {
-    auto s1 = sat_atom(next, ts);
-    set_t<const typename TS::node *> res;
-    for(const auto &node: ts.all_nodes()) {
-      auto succ = node.post_in(ts);
-      if(std::any_of(succ.begin(), succ.end(), [&s1](const auto &v){ return s1.contains(v); })) res.insert(&node);
+    set_t res = sub;
+    std::vector<graph::state_id> frontier{res.begin(), res.end()};
+    std::vector<graph::state_id> next;
+    while(!frontier.empty()) {
+      pr.round(frontier.size());
+      pr.add_pre(frontier.size());
+      for(const auto n: frontier) {
+        for(const size_t p: ts.predecessors(n)) {
+          pr.edge();
+          if(!res.contains(p)) {
+            res.insert(p);
+            next.push_back(p);
+          }
+        }
+      }
+      frontier.swap(next);
+      next.clear();
     }
+
     return res;
   }
 
-  template <graph::TS TS>
-  set_t<const typename TS::node *> sat_e_until(const std::string &pre, const std::string &post, const TS &ts) {
-    set_t<const typename TS::node *> res = sat_atom(post, ts);
-    set_t<const typename TS::node *> restriction = sat_atom(pre, ts);
+  // A G sub: the states of sub that can't reach a state outside of it. The result starts out as sub, and a backward
+  // search from the states outside sub erases everything it reaches, so no negated sets are built.
+  template <graph::TS_view TS>
+  set_t sat_a_always(const set_t &sub, const TS &ts) {
+    probe pr;
+    set_t res = sub;
+    if constexpr(graph::image_TS<TS>) {
+      set_t frontier = ~sub;
+      while(!frontier.empty()) {
+        if(pr.on()) pr.round(frontier.count());
+        pr.pre();
+        frontier = ts.pre_image(frontier) & res;
+        res -= frontier;
+      }
+      return res;
+    }
 
-    set_t<const typename TS::node *> add;
-    for(const auto &n: res) {
-      auto in = intersect(restriction, n->pre_in(ts));
-      add.insert(in.begin(), in.end());
+    std::vector<graph::state_id> frontier;
+    for(size_t s = 0; s < ts.size(); s++) {
+      if(!sub.contains(s)) frontier.push_back((graph::state_id)s);
+    }
+    std::vector<graph::state_id> next;
+    while(!frontier.empty()) {
+      pr.round(frontier.size());
+      pr.add_pre(frontier.size());
+      for(const auto n: frontier) {
+        for(const size_t p: ts.predecessors(n)) {
+          pr.edge();
+          if(res.contains(p)) {
+            res.erase(p);
+            next.push_back(p);
+          }
+        }
+      }
+      frontier.swap(next);
+      next.clear();
     }
-    set_minus_inplace(add, res);
 
-    while(!add.empty()) {
-      res.insert(add.begin(), add.end());
-      decltype(add) cp;
-      add.swap(cp);
+    return res;
+  }
 
-      for(const auto &n: cp) {
-        auto in = intersect(restriction, n->pre_in(ts));
-        add.insert(in.begin(), in.end());
+  // A [pre U post]: a state of pre is added as soon as all of its successors are in (deadlock states of pre right
+  // away, as for the ENF rewrite), by counting down the successors that aren't in yet. Linear in the size of the TS.
+  template <graph::TS_view TS>
+  set_t sat_a_until(const set_t &pre, const set_t &post, const TS &ts) {
+    return a_until([&pre](size_t s) { return pre.contains(s); }, post, ts);
+  }
+
+  // A F sub = A [true U sub].
+  template <graph::TS_view TS>
+  set_t sat_a_future(const set_t &sub, const TS &ts) {
+    return a_until([](size_t) { return true; }, sub, ts);
+  }
+
+  template <graph::TS_view TS, typename F>
+  set_t a_until(F &&in_pre, const set_t &post, const TS &ts) {
+    probe pr;
+    const size_t n = ts.size();
+    set_t res = post;
+    std::vector<std::uint32_t> c(n, 0);
+    std::vector<graph::state_id> frontier{post.begin(), post.end()};
+    for(size_t v = 0; v < n; v++) {
+      if(!in_pre(v) || res.contains(v)) continue;
+      pr.post();
+      for([[maybe_unused]] const size_t s: ts.successors(v)) c[v]++;
+      pr.add_edges(c[v]);
+      if(c[v] == 0) {
+        res.insert(v);
+        frontier.push_back((graph::state_id)v);
       }
+    }
 
-      set_minus_inplace(add, res);
+    std::vector<graph::state_id> next;
+    while(!frontier.empty()) {
+      pr.round(frontier.size());
+      pr.add_pre(frontier.size());
+      for(const auto v: frontier) {
+        for(const size_t p: ts.predecessors(v)) {
+          pr.edge();
+          if(c[p] != 0 && --c[p] == 0) {
+            res.insert(p);
+            next.push_back(p);
+          }
+        }
+      }
+      frontier.swap(next);
+      next.clear();
     }
 
     return res;
   }
 
-  template <graph::TS TS>
-  set_t<const typename TS::node *> sat_e_always(const std::string &atom, const TS &ts) {
-    set_t<const typename TS::node *> res = sat_atom(atom, ts);
-    std::unordered_map<const typename TS::node *, size_t> c;
+  template <graph::TS_view TS>
+  set_t sat_e_always(const set_t &sub, const TS &ts) {
+    if(eg == eg_engine::SCC) return sat_e_always_scc(sub, ts);
+    if(pool) return parallel::e_always(*pool, sub, ts);
+
+    probe pr;
+    set_t res = sub;
+    std::vector<std::uint32_t> c(ts.size(), 0);
+    std::vector<graph::state_id> e;
     for(const auto v: res) {
-      c[v] = intersect(res, v->post_in(ts)).size();
-    }
-    decltype(res) e;
-    for(const auto &[k, v]: c) {
-      if(v == 0) e.insert(k);
+      pr.post();
+      for(const size_t s: ts.successors(v)) {
+        pr.edge();
+        if(res.contains(s)) c[v]++;
+      }
+      if(c[v] == 0) e.push_back((graph::state_id)v);
     }
 
+    // pruned in rounds: every round removes the states whose last surviving successor went in the previous one
+    std::vector<graph::state_id> next;
     while(!e.empty()) {
-      const typename TS::node *n = *e.begin();
-      res.erase(n);
-      e.erase(n);
-
-      for(const auto &p: intersect(res, n->pre_in(ts))) {
-        size_t count = --c[p];
-        if(count == 0) e.insert(p);
+      pr.round(e.size());
+      pr.add_pre(e.size());
+      for(const size_t n: e) {
+        res.erase(n);
+        for(const size_t p: ts.predecessors(n)) {
+          pr.edge();
+          if(res.contains(p) && c[p] != 0 && --c[p] == 0) next.push_back(p);
+        }
       }
+      e.swap(next);
+      next.clear();
     }
 
     return res;
   }
 
-  template <graph::TS TS>
-  set_t<const typename TS::node *> sat(formula::ctlf_node formula, TS &ts) {
-    std::stack<formula::ctlf_node *> backtrack;
-    backtrack.push(&formula);
+  // E G sub holds exactly in the states of sub that can reach (within sub) a cycle lying entirely in sub, i.e. in
+  // E [sub U (states of nontrivial SCCs of sub)]. Strictly linear: one SCC pass and one backward search.
+  template <graph::TS_view TS>
+  set_t sat_e_always_scc(const set_t &sub, const TS &ts) {
+    return sat_e_until(sub, nontrivial_scc_states(ts, sub), ts);
+  }
+
+  // Restricts every path quantifier to fair paths: infinite paths that visit an accepting state of ts infinitely
+  // often. The fair states (those with a fair path) are computed once, here.
+  template <graph::TS_view TS>
+  void make_fair(const TS &ts) {
+    set_t accepting(ts.size());
+    for(const size_t s: ts.accepting()) accepting.insert(s);
+    fairness = fairness_t{ std::move(accepting), set_t() };
+    fairness->fair = sat_fair_e_always(sat_true(ts), ts);
+  }
+
+  // Fair E G sub (Emerson-Lei, with a single fairness set): the states of sub that can reach, within sub, an SCC of sub
+  // with a cycle through an accepting state. One SCC decomposition and one backward search, as for sat_e_always_scc.
+  template <graph::TS_view TS>
+  set_t sat_fair_e_always(const set_t &sub, const TS &ts) {
+    return sat_e_until(sub, fair_scc_states(ts, sub, fairness->accepting), ts);
+  }
+
+  // Fair A [pre U post] = !(fair E [!post U (!pre /\ !post)] \/ fair E G !post).
+  template <graph::TS_view TS>
+  set_t sat_fair_a_until(const set_t &pre, const set_t &post, const TS &ts) {
+    const set_t not_post = ~post;
+    set_t res = sat_e_until(not_post, (not_post - pre) & fairness->fair, ts);
+    res |= sat_fair_e_always(not_post, ts);
+    res.flip();
+    return res;
+  }
+
+  // Under fairness, the existential operators only count witnesses that end in (or stay on) fair states, and the
+  // universal ones are their duals. Nothing for the boolean operators, which aren't affected.
+  template <graph::TS_view TS>
+  std::optional<set_t> sat_fair_node(const formula::formula_dag::node &curr, const std::vector<set_t> &results, const TS &ts) {
+    auto child = [&results, &curr](size_t c) -> const set_t & { return results[curr.children[c]]; };
+    const set_t &fair = fairness->fair;
+    switch(curr.n) {
+      case formula::node_type::E_NEXT: return sat_e_next(child(0) & fair, ts);
+      case formula::node_type::E_UNTIL: return sat_e_until(child(0), child(1) & fair, ts);
+      case formula::node_type::E_ALWAYS: return sat_fair_e_always(child(0), ts);
+      case formula::node_type::E_FUTURE: return sat_e_future(child(0) & fair, ts);
+      case formula::node_type::A_NEXT: return sat_negation(sat_e_next(~child(0) & fair, ts));
+      case formula::node_type::A_UNTIL: return sat_fair_a_until(child(0), child(1), ts);
+      case formula::node_type::A_ALWAYS: return sat_a_always(child(0) | ~fair, ts);
+      case formula::node_type::A_FUTURE: return sat_negation(sat_fair_e_always(~child(0), ts));
+      default: return std::nullopt;
+    }
+  }
 
-    auto mod_sat = [&ts](formula::ctlf_node *ptr, set_t<const typename TS::node *> s) {
-      std::string name = ptr->generate_var();
+  // sat_node on dag[i], recorded in prof (if set). Nested evaluations on the same thread (a thread helping the pool
+  // while it waits) get their own counters.
+  template <graph::TS_view TS>
+  set_t eval_node(const formula::formula_dag &dag, formula::formula_dag::id i, const std::vector<set_t> &results, const TS &ts) {
+    if(prof == nullptr) return sat_node(dag[i], results, ts);
+    op_counters counters;
+    op_counters *outer = std::exchange(active_counters, &counters);
+    const auto start = profiler::clk::now();
+    set_t res = sat_node(dag[i], results, ts);
+    active_counters = outer;
+    prof->add(dag, i, start, res, std::move(counters));
+    return res;
+  }
+
+  void drop(set_t &result) {
+    if(prof != nullptr) prof->release(result);
+    result = set_t();
+  }
+
+  // Computes a single DAG node from the (already computed) results of its children.
+  template <graph::TS_view TS>
+  set_t sat_node(const formula::formula_dag::node &curr, const std::vector<set_t> &results, const TS &ts) {
+    if(fairness) {
+      if(auto res = sat_fair_node(curr, results, ts)) return std::move(*res);
+    }
+    auto child = [&results, &curr](size_t c) -> const set_t & { return results[curr.children[c]]; };
+    switch(curr.n) {
+      case formula::node_type::TRUE: return sat_true(ts);
+      case formula::node_type::ATOMIC: return sat_atom(curr.atom, ts);
+      case formula::node_type::CONJUNCTION: return sat_conjunction(child(0), child(1));
+      case formula::node_type::NEGATION: return sat_negation(child(0));
+      case formula::node_type::E_NEXT: return sat_e_next(child(0), ts);
+      case formula::node_type::E_UNTIL: return sat_e_until(child(0), child(1), ts);
+      case formula::node_type::E_ALWAYS: return sat_e_always(child(0), ts);
+      case formula::node_type::DISJUNCTION: return sat_disjunction(child(0), child(1));
+      case formula::node_type::IMPLICATION: return sat_implication(child(0), child(1));
+      case formula::node_type::E_FUTURE: return sat_e_future(child(0), ts);
+      case formula::node_type::A_NEXT: return sat_a_next(child(0), ts);
+      case formula::node_type::A_UNTIL: return sat_a_until(child(0), child(1), ts);
+      case formula::node_type::A_ALWAYS: return sat_a_always(child(0), ts);
+      case formula::node_type::A_FUTURE: return sat_a_future(child(0), ts);
+    }
+    return {};
+  }
+
+  // Evaluates a batch of roots over one DAG without touching the TS. Every node reachable from any root is computed
+  // exactly once (in topological order), so subformulas shared between roots are reused across the whole batch.
+  // on_result(k, sat) is called as soon as roots[k] is known; intermediate results are dropped once no later root
+  // (or parent) needs them anymore.
+  template <graph::TS_view TS, typename F>
+  void sat_all(const formula::formula_dag &dag, const std::vector<formula::formula_dag::id> &roots, const TS &ts, F &&on_result) {
+    using id = formula::formula_dag::id;
+    if(roots.empty()) return;
+
+    const id top = *std::max_element(roots.begin(), roots.end());
+    std::vector<size_t> uses(top + 1, 0);
+    for(const auto r: roots) uses[r]++;
+    for(id i = top + 1; i-- > 0;) {
+      if(uses[i] == 0) continue;
+      for(const auto c: dag[i].children) uses[c]++;
+    }
 
-      ptr->replace_subtree_by(name);
-      for(auto *ptr: s) {
-        const_cast<typename TS::node *>(ptr)->add_prop(name);
+    std::vector<set_t> results(top + 1);
+    std::vector<bool> done(top + 1, false);
+    std::vector<id> todo;
+    std::vector<id> backtrack;
+    for(size_t k = 0; k < roots.size(); k++) {
+      backtrack.push_back(roots[k]);
+      while(!backtrack.empty()) {
+        id curr = backtrack.back();
+        backtrack.pop_back();
+        if(done[curr]) continue;
+        done[curr] = true;
+        todo.push_back(curr);
+        for(const auto c: dag[curr].children) backtrack.push_back(c);
       }
-    };
 
-    while(!backtrack.empty()) {
-      formula::ctlf_node *curr = backtrack.top();
-      bool can_check = true;
-      for(auto &c: curr->children) {
-        if(c.n != formula::node_type::ATOMIC && c.n != formula::node_type::TRUE) {
-          can_check = false;
-          backtrack.push(&c);
+      std::sort(todo.begin(), todo.end());
+      if(pool && todo.size() > 1) {
+        sat_nodes_parallel(dag, todo, results, uses, ts);
+      }
+      else {
+        for(const auto i: todo) {
+          results[i] = eval_node(dag, i, results, ts);
+          for(const auto c: dag[i].children) {
+            if(--uses[c] == 0) drop(results[c]);
+          }
         }
       }
+      todo.clear();
 
-      if(can_check) {
-        switch(curr->n) {
-          case formula::node_type::TRUE:
-          case formula::node_type::ATOMIC:
-            break;
-          case formula::node_type::CONJUNCTION:
-            mod_sat(curr, sat_conjunction(curr->children[0].atom, curr->children[1].atom, ts));
-            break;
-          case formula::node_type::NEGATION:
-            mod_sat(curr, sat_not_atom(curr->children[0].atom, ts));
-            break;
-          case formula::node_type::E_NEXT:
-            mod_sat(curr, sat_e_next(curr->children[0].atom, ts));
-            break;
-          case formula::node_type::E_UNTIL:
-            mod_sat(curr, sat_e_until(curr->children[0].atom, curr->children[1].atom, ts));
-            break;
-          case formula::node_type::E_ALWAYS:
-            mod_sat(curr, sat_e_always(curr->children[0].atom, ts));
-            break;
-        }
+      on_result(k, std::as_const(results[roots[k]]));
+      if(--uses[roots[k]] == 0) drop(results[roots[k]]);
+    }
+  }
+
+  // Schedules the (topologically sorted) DAG nodes in todo on the pool: a node is submitted as soon as all of its
+  // children are known, so independent subformulas (e.g. both sides of a conjunction) are evaluated concurrently.
+  // The calling thread helps running tasks until every node is done.
+  template <graph::TS_view TS>
+  void sat_nodes_parallel(const formula::formula_dag &dag, const std::vector<formula::formula_dag::id> &todo,
+                          std::vector<set_t> &results, std::vector<size_t> &uses, const TS &ts) {
+    constexpr size_t npos = (size_t)-1;
+    std::vector<size_t> pos(results.size(), npos);
+    for(size_t k = 0; k < todo.size(); k++) pos[todo[k]] = k;
 
-        backtrack.pop();
+    std::vector<size_t> pending(todo.size(), 0);
+    std::vector<std::vector<size_t>> parents(todo.size());
+    for(size_t k = 0; k < todo.size(); k++) {
+      for(const auto c: dag[todo[k]].children) {
+        if(pos[c] == npos) continue;
+        pending[k]++;
+        parents[pos[c]].push_back(k);
       }
     }
 
-    return sat_atom(formula.atom, ts);
+    std::atomic<size_t> left = todo.size();
+    std::function<void(size_t)> run = [&](size_t k) {
+      const auto i = todo[k];
+      results[i] = eval_node(dag, i, results, ts);
+      for(const auto c: dag[i].children) {
+        if(std::atomic_ref<size_t>(uses[c]).fetch_sub(1) == 1) drop(results[c]);
+      }
+      for(const auto p: parents[k]) {
+        if(std::atomic_ref<size_t>(pending[p]).fetch_sub(1) == 1) pool->submit([&run, p]() { run(p); });
+      }
+
+      // run (and everything captured by reference) may be gone as soon as the last node is accounted for
+      thread_pool *p = pool.get();
+      if(left.fetch_sub(1) == 1) p->wake();
+    };
+
+    std::vector<size_t> ready;
+    for(size_t k = 0; k < todo.size(); k++) {
+      if(pending[k] == 0) ready.push_back(k);
+    }
+    for(const auto k: ready) pool->submit([&run, k]() { run(k); });
+    pool->help_until([&left]() { return left.load() == 0; });
+  }
+
+  template <graph::TS_view TS>
+  set_t sat(const formula::formula_dag &dag, formula::formula_dag::id root, const TS &ts) {
+    set_t res;
+    sat_all(dag, { root }, ts, [&res](size_t, const set_t &sat) { res = sat; });
+    return res;
+  }
+
+  template <graph::TS_view TS>
+  set_t sat(const formula::ctlf_node &formula, const TS &ts) {
+    formula::formula_dag dag;
+    auto root = dag.intern(formula);
+    return sat(dag, root, ts);
   }
 
-  template <graph::TS TS>
+  template <graph::TS_view TS>
   bool models(const TS &ts, const formula::ctlf_node &formula) {
-    formula::ctlf_node dup_f = formula;
-    TS dup_ts = ts;
-    auto sat_nodes = sat(dup_f, dup_ts);
-    auto init_nodes = dup_ts.initial_nodes();
-    for(const auto &n: init_nodes) {
-      if(sat_nodes.contains(n)) return true;
-    }
-    return false;
+    return models(ts, sat(formula, ts));
+  }
+
+  template <graph::TS_view TS>
+  bool models(const TS &ts, const set_t &sat_nodes) {
+    return std::ranges::any_of(ts.initial(), [&sat_nodes](size_t s){ return sat_nodes.contains(s); });
   }
+
+  struct fairness_t {
+    set_t accepting;
+    set_t fair;
+  };
+
+  eg_engine eg = eg_engine::COUNTING;
+  std::unique_ptr<thread_pool> pool;
+  // Set by make_fair.
+  std::optional<fairness_t> fairness;
+  // When set, every evaluated subformula is recorded here (see stats.hpp).
+  profiler *prof = nullptr;
 };
 }
 
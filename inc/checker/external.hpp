@@ -0,0 +1,97 @@
+//
+// Created by jay on 8/7/23.
+//
+
+#ifndef CTL_EXTERNAL_HPP
+#define CTL_EXTERNAL_HPP
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include "formula/formula.hpp"
+#include "formula/formula_dag.hpp"
+#include "graph/state_set.hpp"
+#include "graph/external_ts.hpp"
+
+namespace ctl::checker {
+/*
+ * Semi-external checker for an external_ts: every (sub)result is a bitset in memory, while the edges are only ever
+ * streamed from disk in sweeps (see external_ts::sweep). EX and AX take a single sweep. The fixpoints repeat sweeps
+ * over the states that may still change until a sweep changes nothing: EU, EF, AU and AF grow a least fixpoint, EG
+ * and AG shrink a greatest one. Updates are visible within the sweep that makes them and successive sweeps alternate
+ * direction, so long chains usually settle in a handful of sweeps rather than one per step.
+ * Results are exactly those of sat_calc; all of CTL is evaluated natively (no ENF rewriting, so no extra negations).
+ */
+class external_checker {
+public:
+  using set_t = graph::state_set;
+  using id = formula::formula_dag::id;
+
+  explicit inline external_checker(const graph::external_ts &ts) : ts{ts} {}
+
+  // Same contract as sat_calc::sat_all: on_result(k, sat) is called for every root in order, and intermediate results
+  // are dropped as soon as nothing needs them anymore.
+  template <typename F>
+  void sat_all(const formula::formula_dag &dag, const std::vector<id> &roots, F &&on_result);
+  [[nodiscard]] set_t sat(const formula::ctlf_node &formula);
+  [[nodiscard]] bool models(const set_t &sat) const;
+
+  // Number of sweeps over the edges so far.
+  [[nodiscard]] inline size_t sweeps() const { return sweep_count; }
+
+private:
+  set_t eval_node(const formula::formula_dag &dag, id i, const std::vector<set_t> &results);
+  [[nodiscard]] set_t sat_atom(const std::string &atom) const;
+  // EX sub (some successor in sub) or AX sub (all successors in sub).
+  set_t next(const set_t &sub, bool all);
+  // E [pre U post] or A [pre U post]: adds the states of pre with some (all) successors in the result.
+  set_t least(const set_t &pre, set_t post, bool all);
+  // E G sub or A G sub: removes the states with no (not all) successors in the result.
+  set_t greatest(set_t sub, bool all);
+
+  const graph::external_ts &ts;
+  size_t sweep_count = 0;
+};
+
+template <typename F>
+void external_checker::sat_all(const formula::formula_dag &dag, const std::vector<id> &roots, F &&on_result) {
+  if(roots.empty()) return;
+
+  const id top = *std::max_element(roots.begin(), roots.end());
+  std::vector<size_t> uses(top + 1, 0);
+  for(const auto r: roots) uses[r]++;
+  for(id i = top + 1; i-- > 0;) {
+    if(uses[i] == 0) continue;
+    for(const auto c: dag[i].children) uses[c]++;
+  }
+
+  std::vector<set_t> results(top + 1);
+  std::vector<bool> done(top + 1, false);
+  std::vector<id> todo;
+  for(size_t k = 0; k < roots.size(); k++) {
+    std::vector<id> backtrack{ roots[k] };
+    while(!backtrack.empty()) {
+      const id curr = backtrack.back();
+      backtrack.pop_back();
+      if(done[curr]) continue;
+      done[curr] = true;
+      todo.push_back(curr);
+      for(const auto c: dag[curr].children) backtrack.push_back(c);
+    }
+
+    std::sort(todo.begin(), todo.end());
+    for(const auto i: todo) {
+      results[i] = eval_node(dag, i, results);
+      for(const auto c: dag[i].children) {
+        if(--uses[c] == 0) results[c] = set_t();
+      }
+    }
+    todo.clear();
+
+    on_result(k, std::as_const(results[roots[k]]));
+    if(--uses[roots[k]] == 0) results[roots[k]] = set_t();
+  }
+}
+}
+
+#endif //CTL_EXTERNAL_HPP
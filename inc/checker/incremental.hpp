@@ -0,0 +1,73 @@
+//
+// Created by jay on 7/29/23.
+//
+
+#ifndef CTL_INCREMENTAL_HPP
+#define CTL_INCREMENTAL_HPP
+
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include "formula/formula.hpp"
+#include "formula/formula_dag.hpp"
+#include "graph/ts.hpp"
+#include "graph/state_set.hpp"
+#include "checker/checker.hpp"
+
+namespace ctl::checker {
+/*
+ * Keeps the satisfaction sets of a set of watched formulas up to date while a sparse_ts is being edited.
+ * Edits (which must go through this class) only record what changed; update() then walks the formula DAG bottom-up
+ * and recomputes every subformula only on the states it could possibly have changed on:
+ *  - boolean operators: the states where a child changed;
+ *  - EX: predecessors of those states, plus the states whose successors changed;
+ *  - EU/EG: losses (operand states or transitions that disappeared) and gains are handled separately. For the least
+ *    fixpoint EU, gains simply extend the backward search, while losses over-delete every state whose witness might
+ *    have used them and then re-derive those from the surviving ones. For the greatest fixpoint EG it's the other way
+ *    around: losses are pruned one state at a time, while gains recompute the fixpoint on the states that can reach a
+ *    gain, with everything around them as a fixed boundary.
+ * The cost of an update is thus proportional to the affected region rather than to the whole model. The set of states
+ * itself is fixed. Watched formulas are rewritten to ENF first, so only the operators above need an update rule.
+ */
+class incremental {
+public:
+  using set_t = graph::state_set;
+  using id = formula::formula_dag::id;
+
+  explicit incremental(graph::sparse_ts &ts);
+
+  // Starts tracking a formula (any pending edits are applied first) and returns the id to query it with.
+  id watch(const formula::ctlf_node &formula);
+  [[nodiscard]] inline const set_t &sat(id root) const { return results[root]; }
+  [[nodiscard]] bool models(id root) const;
+
+  void add_transition(size_t start, size_t end);
+  void remove_transition(size_t start, size_t end);
+  void add_label(size_t state, const graph::prop &p);
+  void remove_label(size_t state, const graph::prop &p);
+
+  // Brings every watched formula up to date with the edits made since the last update.
+  void update();
+
+private:
+  // All states that can reach a seed through states in `through` (including the seeds themselves).
+  [[nodiscard]] set_t backward_closure(const set_t &seeds, const set_t &through) const;
+  set_t update_node(id i, const std::vector<set_t> &changed);
+  set_t update_e_until(id i, const set_t &pre, const set_t &post, const set_t &pre_changed, const set_t &post_changed);
+  set_t update_e_always(id i, const set_t &sub, const set_t &sub_changed);
+  [[nodiscard]] bool has_label(size_t state, const graph::prop &p) const;
+  void toggle_label(size_t state, const graph::prop &p);
+
+  graph::sparse_ts &ts;
+  sat_calc calc;
+  formula::formula_dag dag;
+  std::vector<set_t> results;
+  set_t added;   // sources of added transitions
+  set_t removed; // sources of removed transitions
+  std::unordered_map<graph::prop, set_t> relabelled;
+  bool dirty = false;
+  std::vector<std::uint32_t> counts; // scratch for EG, only the entries of the current region are meaningful
+};
+}
+
+#endif //CTL_INCREMENTAL_HPP
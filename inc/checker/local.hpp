@@ -0,0 +1,222 @@
+//
+// Created by jay on 7/30/23.
+//
+
+#ifndef CTL_LOCAL_HPP
+#define CTL_LOCAL_HPP
+
+#include <deque>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <ranges>
+#include "formula/formula.hpp"
+#include "formula/formula_dag.hpp"
+#include "graph/ts.hpp"
+#include "graph/state_set.hpp"
+#include "graph/implicit_ts.hpp"
+
+namespace ctl::checker {
+// What local checking needs: forward edges, the initial states, and labels (either as label columns, or evaluated per
+// state, as for a lazy_ts). The number of states may grow while checking.
+template <typename T>
+concept local_TS = requires(const T &ct, size_t s, const graph::prop &p) {
+  { ct.size() } -> std::same_as<size_t>;
+  { ct.successors(s) } -> graph::state_range;
+  { ct.initial() } -> graph::state_range;
+  requires graph::TS_view<T> || requires { { ct.holds(s, p) } -> std::same_as<bool>; };
+};
+
+/*
+ * Local (on-the-fly) model checking: instead of computing the full satisfaction set of every subformula, holds(i, s)
+ * only evaluates the (subformula, state) pairs it needs to decide whether s satisfies node i, and models() stops at the
+ * first initial state that satisfies the root. Results are memoized per DAG node, so every pair is decided at most
+ * once across queries.
+ *  - boolean operators, EX and AX short-circuit;
+ *  - E[a U b] runs a DFS through states satisfying a and stops at the first state satisfying b (or already known to
+ *    satisfy the formula): everything on the DFS stack then holds. If the search runs out, every state it visited
+ *    fails. EF a is the same search through all states;
+ *  - EG a runs the same DFS through states satisfying a, looking for a back edge (a cycle within a) instead;
+ *  - AG, AF and AU search for a counterexample (a path to !a, a cycle within !a, or either of those within !b for
+ *    A[a U b]); their memo holds the outcome of that search, i.e. the negation of the formula.
+ * All searches are iterative, so long paths don't overflow the stack; recursion only goes as deep as the formula.
+ * On a lazy_ts, this explores an implicit TS on the fly: only states reached by some search are ever generated.
+ */
+template <local_TS TS>
+class local_checker {
+public:
+  using id = formula::formula_dag::id;
+
+  local_checker(const TS &ts, const formula::formula_dag &dag) : ts{ts}, dag{dag}, memo(dag.size()), props(dag.size()) {}
+
+  [[nodiscard]] bool holds(id i, size_t state) {
+    const auto &curr = dag[i];
+    switch(curr.n) {
+      case formula::node_type::TRUE:
+        return true;
+      case formula::node_type::ATOMIC:
+        evaluated++;
+        return atom(i, state);
+      case formula::node_type::NEGATION:
+        return !holds(curr.children[0], state);
+      case formula::node_type::CONJUNCTION:
+        return holds(curr.children[0], state) && holds(curr.children[1], state);
+      case formula::node_type::DISJUNCTION:
+        return holds(curr.children[0], state) || holds(curr.children[1], state);
+      case formula::node_type::IMPLICATION:
+        return !holds(curr.children[0], state) || holds(curr.children[1], state);
+      default:
+        break;
+    }
+
+    // universal operators memoize their counterexample search
+    const bool negated = curr.n == formula::node_type::A_ALWAYS || curr.n == formula::node_type::A_FUTURE ||
+                         curr.n == formula::node_type::A_UNTIL;
+    auto &m = memo[i];
+    if(at(m, state) == TRUE || at(m, state) == FALSE) return (at(m, state) == TRUE) != negated;
+    evaluated++;
+    auto sat = [this](id c) { return [this, c](size_t v) { return holds(c, v); }; };
+    auto unsat = [this](id c) { return [this, c](size_t v) { return !holds(c, v); }; };
+    auto always = [](size_t) { return true; };
+    auto never = [](size_t) { return false; };
+    switch(curr.n) {
+      case formula::node_type::E_NEXT: {
+        const bool res = std::ranges::any_of(ts.successors(state), [this, &curr](size_t t) {
+          return holds(curr.children[0], t);
+        });
+        at(m, state) = res ? TRUE : FALSE;
+        break;
+      }
+      case formula::node_type::A_NEXT: {
+        const bool res = std::ranges::all_of(ts.successors(state), [this, &curr](size_t t) {
+          return holds(curr.children[0], t);
+        });
+        at(m, state) = res ? TRUE : FALSE;
+        break;
+      }
+      case formula::node_type::E_UNTIL:
+        search(i, state, sat(curr.children[0]), sat(curr.children[1]), false);
+        break;
+      case formula::node_type::E_FUTURE:
+        search(i, state, always, sat(curr.children[0]), false);
+        break;
+      case formula::node_type::E_ALWAYS:
+        search(i, state, sat(curr.children[0]), never, true);
+        break;
+      case formula::node_type::A_ALWAYS: // !E[true U !a]
+        search(i, state, always, unsat(curr.children[0]), false);
+        break;
+      case formula::node_type::A_FUTURE: // !EG !a
+        search(i, state, unsat(curr.children[0]), never, true);
+        break;
+      case formula::node_type::A_UNTIL: { // !(E[!b U (!a /\ !b)] \/ EG !b)
+        const id a = curr.children[0];
+        const id b = curr.children[1];
+        search(i, state, unsat(b), [this, a, b](size_t v) { return !holds(b, v) && !holds(a, v); }, true);
+        break;
+      }
+      default:
+        break;
+    }
+    return (at(m, state) == TRUE) != negated;
+  }
+
+  [[nodiscard]] bool models(id root) {
+    return std::ranges::any_of(ts.initial(), [this, root](size_t s) { return holds(root, s); });
+  }
+
+  // Number of (subformula, state) pairs that had to be evaluated so far.
+  [[nodiscard]] inline size_t explored() const { return evaluated; }
+
+private:
+  // Per-state memo: decided (TRUE/FALSE), or the DFS status of the current search (ON_STACK/FINISHED).
+  enum status : std::uint8_t { UNKNOWN, TRUE, FALSE, ON_STACK, FINISHED };
+  // successors() may return a range by value, so each frame keeps it alive (frames never move: they live in a deque)
+  using range = decltype(std::declval<const TS &>().successors(0));
+  using iter = decltype(std::ranges::begin(std::declval<range &>()));
+  struct frame {
+    size_t state;
+    range succ;
+    iter it;
+  };
+
+  // Memo entry of state s; tables grow lazily, as states may be discovered while checking.
+  std::uint8_t &at(std::vector<std::uint8_t> &m, size_t s) {
+    if(s >= m.size()) m.resize(std::max(s + 1, ts.size()), UNKNOWN);
+    return m[s];
+  }
+
+  bool atom(id i, size_t state) {
+    if constexpr(graph::TS_view<TS>) {
+      if(!props[i].resolved) props[i] = { true, ts.propositions().find(dag[i].atom) };
+      if(props[i].id == graph::prop_table::npos) return false;
+      const std::span<const graph::state_set::word> words = ts.label(props[i].id).words();
+      return graph::state_set_view(words, ts.size()).contains(state);
+    }
+    else {
+      return ts.holds(state, dag[i].atom);
+    }
+  }
+
+  // DFS from start through states satisfying `through`. It succeeds on reaching a state that satisfies `target`, a
+  // state on the stack (if looking for a cycle), or any state already known to satisfy node i's search.
+  template <typename Through, typename Target>
+  void search(id i, size_t start, Through &&through, Target &&target, bool cycle) {
+    auto &m = memo[i];
+    std::deque<frame> stack;
+    std::vector<graph::state_id> visited;
+    bool found = false;
+
+    // returns whether v completes the search; otherwise v is either skipped or pushed
+    auto enter = [&](size_t v) {
+      if(at(m, v) == TRUE) return true;
+      if(at(m, v) == ON_STACK) return cycle;
+      if(at(m, v) == FALSE || at(m, v) == FINISHED) return false;
+      if(target(v)) {
+        at(m, v) = TRUE;
+        return true;
+      }
+      if(!through(v)) {
+        at(m, v) = FALSE;
+        return false;
+      }
+      at(m, v) = ON_STACK;
+      visited.push_back(v);
+      auto &f = stack.emplace_back(v, ts.successors(v));
+      f.it = std::ranges::begin(f.succ);
+      return false;
+    };
+
+    found = enter(start);
+    while(!found && !stack.empty()) {
+      auto &top = stack.back();
+      if(top.it == std::ranges::end(top.succ)) {
+        m[top.state] = FINISHED;
+        stack.pop_back();
+        continue;
+      }
+      const size_t next = *top.it;
+      ++top.it;
+      found = enter(next);
+    }
+
+    // on success, the stack is a witness path for all of its states; the other visited states are undecided. On
+    // failure, the search exhausted everything reachable from each visited state.
+    for(const auto v: visited) m[v] = found ? UNKNOWN : FALSE;
+    for(const auto &f: stack) m[f.state] = TRUE;
+  }
+
+  struct prop_ref {
+    bool resolved = false;
+    graph::prop_id id = graph::prop_table::npos;
+  };
+
+  const TS &ts;
+  const formula::formula_dag &dag;
+  std::vector<std::vector<std::uint8_t>> memo;
+  std::vector<prop_ref> props;
+  size_t evaluated = 0;
+};
+}
+
+#endif //CTL_LOCAL_HPP
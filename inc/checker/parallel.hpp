@@ -0,0 +1,139 @@
+//
+// Created by jay on 7/18/23.
+//
+
+#ifndef CTL_PARALLEL_HPP
+#define CTL_PARALLEL_HPP
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include "thread_pool.hpp"
+#include "graph/ts.hpp"
+#include "graph/state_set.hpp"
+#include "checker/stats.hpp"
+
+namespace ctl::checker {
+/*
+ * Frontier-parallel fixpoint engines. Each round splits the current frontier into chunks which are handed out to the
+ * pool (with work stealing between participants); shared membership is tracked in atomically updated bitsets and every
+ * chunk collects its part of the next frontier locally, so no locks are taken inside the rounds.
+ * Both engines compute exactly the same sets as their serial counterparts in sat_calc.
+ */
+namespace parallel {
+constexpr size_t min_chunk = 256;
+
+inline size_t chunk_size(const thread_pool &pool, size_t work) {
+  return std::max(min_chunk, work / (pool.size() * 8) + 1);
+}
+
+// Concatenates the per-chunk outputs into the next frontier.
+inline void gather(std::vector<std::vector<graph::state_id>> &outputs, std::vector<graph::state_id> &frontier) {
+  frontier.clear();
+  for(auto &o: outputs) {
+    frontier.insert(frontier.end(), o.begin(), o.end());
+    o.clear();
+  }
+}
+
+// E pre U post: level-synchronous backward reachability from post, restricted to pre.
+template <graph::TS_view TS>
+graph::state_set e_until(thread_pool &pool, const graph::state_set &pre, const graph::state_set &post, const TS &ts) {
+  probe pr;
+  std::atomic<size_t> edges = 0;
+  graph::state_set res = post;
+  std::vector<graph::state_id> frontier{post.begin(), post.end()};
+  std::vector<std::vector<graph::state_id>> outputs;
+
+  while(!frontier.empty()) {
+    pr.round(frontier.size());
+    pr.add_pre(frontier.size());
+    const size_t cs = chunk_size(pool, frontier.size());
+    const size_t chunks = (frontier.size() + cs - 1) / cs;
+    outputs.resize(std::max(outputs.size(), chunks));
+
+    pool.parallel_for(chunks, [&](size_t c) {
+      auto &out = outputs[c];
+      size_t scanned = 0;
+      const size_t end = std::min(frontier.size(), (c + 1) * cs);
+      for(size_t i = c * cs; i < end; i++) {
+        for(const size_t p: ts.predecessors(frontier[i])) {
+          scanned++;
+          if(pre.contains(p) && !res.atomic_contains(p) && res.atomic_insert(p)) out.push_back(p);
+        }
+      }
+      edges.fetch_add(scanned, std::memory_order_relaxed);
+    });
+
+    gather(outputs, frontier);
+  }
+
+  pr.add_edges(edges.load());
+  return res;
+}
+
+// E G sub: count-decrement pruning. A state is removed once none of its successors within sub survive.
+template <graph::TS_view TS>
+graph::state_set e_always(thread_pool &pool, const graph::state_set &sub, const TS &ts) {
+  probe pr;
+  std::atomic<size_t> edges = 0;
+  const size_t n = ts.size();
+  std::vector<std::uint32_t> count(n, 0);
+  std::vector<std::vector<graph::state_id>> outputs;
+  std::vector<graph::state_id> frontier;
+
+  const size_t cs = chunk_size(pool, n);
+  const size_t chunks = (n + cs - 1) / cs;
+  outputs.resize(chunks);
+  pool.parallel_for(chunks, [&](size_t c) {
+    size_t scanned = 0;
+    const size_t end = std::min(n, (c + 1) * cs);
+    for(size_t v = c * cs; v < end; v++) {
+      if(!sub.contains(v)) continue;
+      for(const size_t s: ts.successors(v)) {
+        scanned++;
+        if(sub.contains(s)) count[v]++;
+      }
+      if(count[v] == 0) outputs[c].push_back((graph::state_id)v);
+    }
+    edges.fetch_add(scanned, std::memory_order_relaxed);
+  });
+  if(pr.on()) pr.add_post(sub.count());
+  gather(outputs, frontier);
+
+  graph::state_set removed(n);
+  for(const auto v: frontier) removed.insert(v);
+
+  while(!frontier.empty()) {
+    pr.round(frontier.size());
+    pr.add_pre(frontier.size());
+    const size_t fcs = chunk_size(pool, frontier.size());
+    const size_t fchunks = (frontier.size() + fcs - 1) / fcs;
+    outputs.resize(std::max(outputs.size(), fchunks));
+
+    pool.parallel_for(fchunks, [&](size_t c) {
+      auto &out = outputs[c];
+      size_t scanned = 0;
+      const size_t end = std::min(frontier.size(), (c + 1) * fcs);
+      for(size_t i = c * fcs; i < end; i++) {
+        for(const size_t p: ts.predecessors(frontier[i])) {
+          scanned++;
+          if(sub.contains(p) && std::atomic_ref<std::uint32_t>(count[p]).fetch_sub(1, std::memory_order_relaxed) == 1) {
+            removed.atomic_insert(p);
+            out.push_back(p);
+          }
+        }
+      }
+      edges.fetch_add(scanned, std::memory_order_relaxed);
+    });
+
+    gather(outputs, frontier);
+  }
+
+  pr.add_edges(edges.load());
+  return sub - removed;
+}
+}
+}
+
+#endif //CTL_PARALLEL_HPP
@@ -0,0 +1,116 @@
+//
+// Created by jay on 7/21/23.
+//
+
+#ifndef CTL_SCC_HPP
+#define CTL_SCC_HPP
+
+#include <vector>
+#include <deque>
+#include <span>
+#include <ranges>
+#include <utility>
+#include <algorithm>
+#include "graph/ts.hpp"
+#include "graph/state_set.hpp"
+#include "checker/stats.hpp"
+
+namespace ctl::checker {
+/*
+ * Tarjan's SCC decomposition of the subgraph induced by `within`, in O(|S| + |R|). The recursion is replaced by an
+ * explicit stack of (state, successor iterator) frames, so million-state SCCs don't overflow the call stack.
+ * on_scc(members) is called once per SCC (in reverse topological order) with a span over its states.
+ */
+template <graph::TS_view TS, typename F>
+void for_each_scc(const TS &ts, const graph::state_set &within, F &&on_scc) {
+  constexpr graph::state_id npos = (graph::state_id)-1;
+  using range_t = decltype(ts.successors(size_t{0}));
+  struct frame {
+    size_t v;
+    range_t succ;
+    std::ranges::iterator_t<range_t> it;
+  };
+
+  std::vector<graph::state_id> index(ts.size(), npos);
+  std::vector<graph::state_id> low(ts.size(), 0);
+  graph::state_set on_stack(ts.size());
+  std::vector<graph::state_id> stack;
+  std::deque<frame> calls; // a deque never moves its elements, so the iterators stay valid while we push
+  graph::state_id counter = 0;
+  probe pr;
+
+  auto open = [&](size_t v) {
+    pr.post();
+    index[v] = low[v] = counter++;
+    stack.push_back((graph::state_id)v);
+    on_stack.insert(v);
+    calls.push_back(frame{ v, ts.successors(v), {} });
+    calls.back().it = std::ranges::begin(calls.back().succ);
+  };
+
+  for(const size_t root: within) {
+    if(index[root] != npos) continue;
+    open(root);
+
+    while(!calls.empty()) {
+      auto &f = calls.back();
+      if(f.it != std::ranges::end(f.succ)) {
+        const size_t w = *f.it;
+        ++f.it;
+        pr.edge();
+        if(!within.contains(w)) continue;
+        if(index[w] == npos) open(w);
+        else if(on_stack.contains(w)) low[f.v] = std::min(low[f.v], index[w]);
+        continue;
+      }
+
+      const size_t v = f.v;
+      calls.pop_back();
+      if(!calls.empty()) low[calls.back().v] = std::min(low[calls.back().v], low[v]);
+      if(low[v] != index[v]) continue;
+
+      size_t pos = stack.size();
+      do { --pos; } while(stack[pos] != v);
+      std::span<const graph::state_id> members(stack.data() + pos, stack.size() - pos);
+      on_scc(members);
+      for(const auto m: members) on_stack.erase(m);
+      stack.resize(pos);
+    }
+  }
+}
+
+// Whether an SCC contains a cycle: it has more than one state, or its only state has a self-loop.
+template <graph::TS_view TS>
+bool is_nontrivial(const TS &ts, std::span<const graph::state_id> members) {
+  if(members.size() > 1) return true;
+  const size_t v = members[0];
+  return std::ranges::any_of(ts.successors(v), [v](size_t w) { return w == v; });
+}
+
+// States of `within` that lie on a cycle within `within`: members of SCCs with more than one state or with a self-loop.
+template <graph::TS_view TS>
+graph::state_set nontrivial_scc_states(const TS &ts, const graph::state_set &within) {
+  graph::state_set res(within.size());
+  for_each_scc(ts, within, [&](std::span<const graph::state_id> members) {
+    if(!is_nontrivial(ts, members)) return;
+    for(const auto m: members) res.insert(m);
+  });
+  return res;
+}
+
+// States of `within` that lie on a cycle within `within` through a state of `accepting`: members of the nontrivial SCCs
+// that contain an accepting state. Such a cycle can be repeated forever, so every path into one of them can be
+// extended to a fair path.
+template <graph::TS_view TS>
+graph::state_set fair_scc_states(const TS &ts, const graph::state_set &within, const graph::state_set &accepting) {
+  graph::state_set res(within.size());
+  for_each_scc(ts, within, [&](std::span<const graph::state_id> members) {
+    if(std::ranges::none_of(members, [&accepting](size_t m) { return accepting.contains(m); })) return;
+    if(!is_nontrivial(ts, members)) return;
+    for(const auto m: members) res.insert(m);
+  });
+  return res;
+}
+}
+
+#endif //CTL_SCC_HPP
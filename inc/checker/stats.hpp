@@ -0,0 +1,122 @@
+//
+// Created by jay on 8/2/23.
+//
+
+#ifndef CTL_STATS_HPP
+#define CTL_STATS_HPP
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <thread>
+#include <iostream>
+#include <unordered_map>
+#include "formula/formula_dag.hpp"
+#include "graph/state_set.hpp"
+
+namespace ctl::checker {
+// What a kernel did while computing one subformula.
+struct op_counters {
+  size_t iterations = 0;          // fixpoint rounds (BFS levels, pruning rounds)
+  std::vector<size_t> frontiers;  // frontier size at the start of every round
+  size_t pre_calls = 0;           // predecessor lists or pre-images requested
+  size_t post_calls = 0;          // successor lists or post-images requested
+  size_t edges = 0;               // adjacency entries scanned
+};
+
+// The counters of the subformula being evaluated on this thread; null when profiling is off.
+inline thread_local op_counters *active_counters = nullptr;
+
+/*
+ * Kernel-side view of active_counters. The per-edge and per-call counts go to plain locals, which are only flushed
+ * (once) when the probe goes out of scope, so instrumented loops cost next to nothing when profiling is off.
+ * A probe belongs to one thread; the parallel engines sum their per-chunk counts and add them afterwards.
+ */
+class probe {
+public:
+  inline probe() : c{active_counters} {}
+  probe(const probe &) = delete;
+  probe &operator=(const probe &) = delete;
+  inline ~probe() {
+    if(c == nullptr) return;
+    c->pre_calls += pre_calls;
+    c->post_calls += post_calls;
+    c->edges += edges;
+  }
+
+  [[nodiscard]] inline bool on() const { return c != nullptr; }
+  inline void pre() { pre_calls++; }
+  inline void post() { post_calls++; }
+  inline void edge() { edges++; }
+  inline void add_pre(size_t k) { pre_calls += k; }
+  inline void add_post(size_t k) { post_calls += k; }
+  inline void add_edges(size_t k) { edges += k; }
+  inline void round(size_t frontier) {
+    if(c == nullptr) return;
+    c->iterations++;
+    c->frontiers.push_back(frontier);
+  }
+
+private:
+  op_counters *c;
+  size_t pre_calls = 0;
+  size_t post_calls = 0;
+  size_t edges = 0;
+};
+
+/*
+ * Collects one record per evaluated subformula (wall time, thread, result size, kernel counters) plus the number of
+ * result-set bytes alive at any time, and writes them as JSON or as a Chrome trace-event file (chrome://tracing,
+ * Perfetto). Recording is thread-safe, so it also works with the parallel scheduler.
+ * All records should come from the same formula DAG (node ids are used to refer to subformulas).
+ */
+class profiler {
+public:
+  using clk = std::chrono::steady_clock;
+
+  struct record {
+    formula::formula_dag::id node;
+    formula::node_type op;
+    std::vector<formula::formula_dag::id> children;
+    std::string formula;
+    size_t thread;
+    double start_us;
+    double duration_us;
+    size_t result_states;
+    size_t result_bytes;
+    size_t live_bytes; // all live result sets, right after this one was computed
+    op_counters counters;
+  };
+
+  inline profiler() : origin{clk::now()} {}
+
+  // Microseconds since the profiler was created.
+  [[nodiscard]] double now_us() const;
+  void add(const formula::formula_dag &dag, formula::formula_dag::id node, clk::time_point start,
+           const graph::state_set &result, op_counters &&counters);
+  void release(const graph::state_set &result);
+
+  [[nodiscard]] inline const std::vector<record> &records() const { return recs; }
+  [[nodiscard]] inline size_t peak_bytes() const { return peak.load(); }
+  void write_json(std::ostream &out) const;
+  void write_trace(std::ostream &out) const;
+
+private:
+  [[nodiscard]] static size_t bytes(const graph::state_set &s);
+  // Describes node in terms of its children's descriptions; a child with a long description is referenced by id.
+  [[nodiscard]] std::string describe(const formula::formula_dag &dag, formula::formula_dag::id node) const;
+  [[nodiscard]] static const char *op_name(formula::node_type n);
+
+  clk::time_point origin;
+  mutable std::mutex m;
+  std::vector<record> recs;
+  std::vector<std::string> text; // description per node id
+  std::unordered_map<std::thread::id, size_t> threads;
+  std::atomic<size_t> live = 0;
+  std::atomic<size_t> peak = 0;
+};
+}
+
+#endif //CTL_STATS_HPP
@@ -0,0 +1,183 @@
+//
+// Created by jay on 7/25/23.
+//
+
+#ifndef CTL_SYMBOLIC_HPP
+#define CTL_SYMBOLIC_HPP
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include "formula/formula.hpp"
+#include "formula/formula_dag.hpp"
+#include "graph/symbolic_ts.hpp"
+
+namespace ctl::checker {
+/*
+ * Symbolic counterpart of sat_calc: satisfaction sets are BDDs over the current-state variables of a symbolic_ts and
+ * every temporal operator is a fixpoint over pre-images (relational products), so the cost depends on the BDD sizes
+ * rather than on the number of states.
+ */
+struct symbolic_sat_calc {
+  using set_t = graph::symbolic_ts::set_t;
+
+  set_t sat_atom(const std::string &atom, const graph::symbolic_ts &ts) {
+    return ts.label(atom);
+  }
+
+  set_t sat_true(const graph::symbolic_ts &ts) {
+    return ts.states();
+  }
+
+  set_t sat_negation(const set_t &s, const graph::symbolic_ts &ts) {
+    return ts.states() & !s;
+  }
+
+  set_t sat_conjunction(const set_t &s1, const set_t &s2) {
+    return s1 & s2;
+  }
+
+  set_t sat_disjunction(const set_t &s1, const set_t &s2) {
+    return s1 | s2;
+  }
+
+  set_t sat_implication(const set_t &s1, const set_t &s2, const graph::symbolic_ts &ts) {
+    return ts.states() & ((!s1) | s2);
+  }
+
+  set_t sat_e_next(const set_t &s1, const graph::symbolic_ts &ts) {
+    return ts.pre_image(s1);
+  }
+
+  // Every state without a successor outside sub.
+  set_t sat_a_next(const set_t &sub, const graph::symbolic_ts &ts) {
+    return ts.states() & !ts.pre_image(ts.states() & !sub);
+  }
+
+  // Least fixpoint Z = post \/ (pre /\ EX Z); only the states added in the last round are pushed through the
+  // pre-image.
+  set_t sat_e_until(const set_t &pre, const set_t &post, const graph::symbolic_ts &ts) {
+    set_t res = post;
+    set_t frontier = post;
+    while(!frontier.is_zero()) {
+      set_t added = pre & ts.pre_image(frontier) & !res;
+      res |= added;
+      frontier = std::move(added);
+    }
+    return res;
+  }
+
+  // Least fixpoint Z = sub \/ EX Z, pushing only the last round's states through the pre-image.
+  set_t sat_e_future(const set_t &sub, const graph::symbolic_ts &ts) {
+    set_t res = sub;
+    set_t frontier = sub;
+    while(!frontier.is_zero()) {
+      set_t added = ts.pre_image(frontier) & !res;
+      res |= added;
+      frontier = std::move(added);
+    }
+    return res;
+  }
+
+  // The states that can't reach a state outside sub.
+  set_t sat_a_always(const set_t &sub, const graph::symbolic_ts &ts) {
+    return ts.states() & !sat_e_future(ts.states() & !sub, ts);
+  }
+
+  // Least fixpoint Z = post \/ (pre /\ AX Z).
+  set_t sat_a_until(const set_t &pre, const set_t &post, const graph::symbolic_ts &ts) {
+    set_t res = post;
+    while(true) {
+      set_t next = res | (pre & !ts.pre_image(ts.states() & !res));
+      if(next == res) return res;
+      res = std::move(next);
+    }
+  }
+
+  set_t sat_a_future(const set_t &sub, const graph::symbolic_ts &ts) {
+    return sat_a_until(ts.states(), sub, ts);
+  }
+
+  // Greatest fixpoint Z = sub /\ EX Z.
+  set_t sat_e_always(const set_t &sub, const graph::symbolic_ts &ts) {
+    set_t res = sub;
+    while(true) {
+      set_t next = res & ts.pre_image(res);
+      if(next == res) return res;
+      res = std::move(next);
+    }
+  }
+
+  set_t sat_node(const formula::formula_dag::node &curr, const std::vector<set_t> &results, const graph::symbolic_ts &ts) {
+    auto child = [&results, &curr](size_t c) -> const set_t & { return results[curr.children[c]]; };
+    switch(curr.n) {
+      case formula::node_type::TRUE: return sat_true(ts);
+      case formula::node_type::ATOMIC: return sat_atom(curr.atom, ts);
+      case formula::node_type::CONJUNCTION: return sat_conjunction(child(0), child(1));
+      case formula::node_type::NEGATION: return sat_negation(child(0), ts);
+      case formula::node_type::E_NEXT: return sat_e_next(child(0), ts);
+      case formula::node_type::E_UNTIL: return sat_e_until(child(0), child(1), ts);
+      case formula::node_type::E_ALWAYS: return sat_e_always(child(0), ts);
+      case formula::node_type::DISJUNCTION: return sat_disjunction(child(0), child(1));
+      case formula::node_type::IMPLICATION: return sat_implication(child(0), child(1), ts);
+      case formula::node_type::E_FUTURE: return sat_e_future(child(0), ts);
+      case formula::node_type::A_NEXT: return sat_a_next(child(0), ts);
+      case formula::node_type::A_UNTIL: return sat_a_until(child(0), child(1), ts);
+      case formula::node_type::A_ALWAYS: return sat_a_always(child(0), ts);
+      case formula::node_type::A_FUTURE: return sat_a_future(child(0), ts);
+    }
+    return {};
+  }
+
+  // Same contract as sat_calc::sat_all; BDDs are cheap to keep around, so every computed node is cached for the
+  // whole batch.
+  template <typename F>
+  void sat_all(const formula::formula_dag &dag, const std::vector<formula::formula_dag::id> &roots,
+               const graph::symbolic_ts &ts, F &&on_result) {
+    std::vector<set_t> results(dag.size());
+    std::vector<bool> done(dag.size(), false);
+    std::vector<formula::formula_dag::id> todo;
+    for(size_t k = 0; k < roots.size(); k++) {
+      if(!done[roots[k]]) {
+        done[roots[k]] = true;
+        todo.push_back(roots[k]);
+      }
+      for(size_t i = 0; i < todo.size(); i++) {
+        for(const auto c: dag[todo[i]].children) {
+          if(done[c]) continue;
+          done[c] = true;
+          todo.push_back(c);
+        }
+      }
+
+      // ids are topologically ordered, so every child has a smaller id than its parents
+      std::sort(todo.begin(), todo.end());
+      for(const auto i: todo) results[i] = sat_node(dag[i], results, ts);
+      todo.clear();
+      on_result(k, std::as_const(results[roots[k]]));
+    }
+  }
+
+  set_t sat(const formula::formula_dag &dag, formula::formula_dag::id root, const graph::symbolic_ts &ts) {
+    set_t res;
+    sat_all(dag, { root }, ts, [&res](size_t, const set_t &sat) { res = sat; });
+    return res;
+  }
+
+  set_t sat(const formula::ctlf_node &formula, const graph::symbolic_ts &ts) {
+    formula::formula_dag dag;
+    auto root = dag.intern(formula);
+    return sat(dag, root, ts);
+  }
+
+  bool models(const graph::symbolic_ts &ts, const formula::ctlf_node &formula) {
+    return models(ts, sat(formula, ts));
+  }
+
+  bool models(const graph::symbolic_ts &ts, const set_t &sat_nodes) {
+    return !(ts.initial() & sat_nodes).is_zero();
+  }
+};
+}
+
+#endif //CTL_SYMBOLIC_HPP
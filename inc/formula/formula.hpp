@@ -11,7 +11,10 @@
 #include <string>
 
 namespace ctl::formula {
-enum struct node_type { TRUE, ATOMIC, CONJUNCTION, NEGATION, E_NEXT, E_UNTIL, E_ALWAYS };
+enum struct node_type {
+  TRUE, ATOMIC, CONJUNCTION, NEGATION, E_NEXT, E_UNTIL, E_ALWAYS,
+  DISJUNCTION, IMPLICATION, E_FUTURE, A_NEXT, A_UNTIL, A_ALWAYS, A_FUTURE
+};
 
 class ctlf_node {
 public:
@@ -19,13 +22,11 @@ public:
   std::string atom;
   std::vector<ctlf_node> children;
 
-  [[nodiscard]] std::string generate_var() const;
-  void replace_subtree_by(const std::string &replacement);
+  // The equivalent formula using only the ENF operators (TRUE, ATOMIC, CONJUNCTION, NEGATION, E_NEXT, E_UNTIL,
+  // E_ALWAYS).
+  [[nodiscard]] ctlf_node to_enf() const;
   void dump() const;
   void dump_tree(size_t d = 0) const;
-
-private:
-  static size_t counter;
 };
 }
 
@@ -0,0 +1,45 @@
+//
+// Created by jay on 7/14/23.
+//
+
+#ifndef CTL_FORMULA_DAG_HPP
+#define CTL_FORMULA_DAG_HPP
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include "formula.hpp"
+
+namespace ctl::formula {
+/*
+ * Hash-consed formula representation: structurally equal subformulas (up to the order of conjuncts and disjuncts) are
+ * interned as a single node. Children are always interned before their parents, so node ids are a topological order.
+ */
+class formula_dag {
+public:
+  using id = size_t;
+
+  struct node {
+    node_type n;
+    std::string atom;
+    std::vector<id> children;
+
+    bool operator==(const node &other) const = default;
+  };
+
+  id intern(const ctlf_node &formula);
+  id make(node_type n, std::string atom, std::vector<id> children);
+  [[nodiscard]] inline const node &operator[](id i) const { return nodes[i]; }
+  [[nodiscard]] inline size_t size() const { return nodes.size(); }
+
+private:
+  struct node_hash {
+    size_t operator()(const node &n) const;
+  };
+
+  std::vector<node> nodes;
+  std::unordered_map<node, id, node_hash> lookup;
+};
+}
+
+#endif //CTL_FORMULA_DAG_HPP
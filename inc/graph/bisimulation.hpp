@@ -0,0 +1,142 @@
+//
+// Created by jay on 8/5/23.
+//
+
+#ifndef CTL_BISIMULATION_HPP
+#define CTL_BISIMULATION_HPP
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <unordered_map>
+#include "thread_pool.hpp"
+#include "graph/ts.hpp"
+#include "graph/state_set.hpp"
+#include "graph/reduction.hpp"
+
+namespace ctl::graph {
+namespace detail {
+// Per-state signatures in CSR form: the signature of s is data[offsets[s] .. offsets[s] + length[s]).
+struct signatures {
+  std::vector<size_t> offsets;
+  std::vector<size_t> length;
+  std::vector<size_t> data;
+  std::vector<size_t> hash;
+
+  [[nodiscard]] inline std::span<const size_t> of(size_t s) const { return { data.data() + offsets[s], length[s] }; }
+  void rehash(size_t s) {
+    size_t h = length[s];
+    for(const auto v: of(s)) h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    hash[s] = h;
+  }
+};
+
+// Numbers the distinct signatures in order of first appearance; returns the number of blocks.
+inline size_t number_blocks(const signatures &sig, std::vector<size_t> &block) {
+  auto h = [&sig](size_t s) { return sig.hash[s]; };
+  auto eq = [&sig](size_t a, size_t b) { return std::ranges::equal(sig.of(a), sig.of(b)); };
+  std::unordered_map<size_t, size_t, decltype(h), decltype(eq)> ids(block.size(), h, eq);
+  for(size_t s = 0; s < block.size(); s++) block[s] = ids.try_emplace(s, ids.size()).first->second;
+  return ids.size();
+}
+}
+
+/*
+ * Bisimulation quotient by signature-based partition refinement. States start out grouped by their labels (and by
+ * whether they're accepting, so the quotient can be checked under fairness as well). Every round then splits the
+ * blocks by the signature of each state, i.e. its block together with the set of blocks it has transitions into,
+ * until no block splits anymore. Bisimilar states satisfy the same (fair) CTL formulas, so checking the quotient and
+ * lifting the result back gives exactly the result on ts.
+ * A round is linear in the size of the TS; the signatures are computed in parallel when a pool is given, only the
+ * numbering of the new blocks is sequential. Each block becomes one state, named after its first member.
+ */
+template <TS_view TS>
+reduction bisimulation_quotient(const TS &ts, thread_pool *pool = nullptr) {
+  const size_t n = ts.size();
+  detail::signatures sig;
+  sig.offsets.assign(n + 1, 0);
+  sig.length.assign(n, 0);
+  sig.hash.assign(n, 0);
+
+  // initial partition: the accepting flag followed by the (ascending) ids of the propositions holding in the state
+  state_set accepting(n);
+  for(const size_t s: ts.accepting()) accepting.insert(s);
+  const prop_table &props = ts.propositions();
+  std::vector<state_set_view> columns;
+  for(prop_id id = 0; id < props.size(); id++) {
+    const std::span<const state_set::word> words = ts.label(id).words();
+    columns.emplace_back(words, std::min(n, words.size() * state_set::word_bits));
+    for(const size_t s: columns.back()) sig.length[s]++;
+  }
+  for(size_t s = 0; s < n; s++) sig.offsets[s + 1] = sig.offsets[s] + 1 + sig.length[s];
+  sig.data.resize(sig.offsets[n]);
+  for(size_t s = 0; s < n; s++) {
+    sig.data[sig.offsets[s]] = accepting.contains(s) ? 1 : 0;
+    sig.length[s] = 1;
+  }
+  for(prop_id id = 0; id < columns.size(); id++) {
+    for(const size_t s: columns[id]) sig.data[sig.offsets[s] + sig.length[s]++] = id;
+  }
+  for(size_t s = 0; s < n; s++) sig.rehash(s);
+
+  std::vector<size_t> block(n);
+  size_t blocks = detail::number_blocks(sig, block);
+
+  // from here on, signatures are (own block, successor blocks...): room for one entry per transition, plus one
+  for(size_t s = 0; s < n; s++) sig.offsets[s + 1] = sig.offsets[s] + 1 + std::ranges::distance(ts.successors(s));
+  sig.data.resize(sig.offsets[n]);
+
+  auto sign = [&](size_t first, size_t last) {
+    for(size_t s = first; s < last; s++) {
+      size_t *out = sig.data.data() + sig.offsets[s];
+      size_t len = 0;
+      for(const size_t t: ts.successors(s)) out[1 + len++] = block[t];
+      std::sort(out + 1, out + 1 + len);
+      len = std::unique(out + 1, out + 1 + len) - (out + 1);
+      out[0] = block[s];
+      sig.length[s] = len + 1;
+      sig.rehash(s);
+    }
+  };
+
+  while(true) {
+    if(pool != nullptr && n > 4096) {
+      const size_t cs = std::max<size_t>(1024, n / (pool->size() * 8) + 1);
+      pool->parallel_for((n + cs - 1) / cs, [&](size_t c) { sign(c * cs, std::min(n, (c + 1) * cs)); });
+    }
+    else {
+      sign(0, n);
+    }
+    // blocks only ever split, so the partition is stable as soon as their number stays the same
+    const size_t next = detail::number_blocks(sig, block);
+    if(next == blocks) break;
+    blocks = next;
+  }
+
+  // the partition (and so the numbering by first appearance) didn't change in the last round, so its signatures are
+  // exactly the successor blocks of every state
+  std::vector<size_t> rep(blocks, reduction::npos);
+  for(size_t s = 0; s < n; s++) {
+    if(rep[block[s]] == reduction::npos) rep[block[s]] = s;
+  }
+  state_set initial(blocks);
+  for(const size_t s: ts.initial()) initial.insert(block[s]);
+
+  reduction res{ .ts = {}, .image = std::move(block) };
+  for(size_t b = 0; b < blocks; b++) {
+    res.ts.add(ts.name(rep[b]), {}, initial.contains(b), accepting.contains(rep[b]));
+  }
+  for(size_t b = 0; b < blocks; b++) {
+    for(const size_t t: sig.of(rep[b]).subspan(1)) res.ts.add_edge(b, t);
+  }
+  for(prop_id id = 0; id < columns.size(); id++) {
+    for(const size_t s: columns[id]) {
+      if(rep[res.image[s]] == s) res.ts.add_label(res.image[s], props.name(id));
+    }
+  }
+  res.ts.freeze(pool);
+  return res;
+}
+}
+
+#endif //CTL_BISIMULATION_HPP
@@ -0,0 +1,47 @@
+//
+// Created by jay on 7/28/23.
+//
+
+#ifndef CTL_BIT_MATRIX_HPP
+#define CTL_BIT_MATRIX_HPP
+
+#include <span>
+#include <vector>
+#include "graph/state_set.hpp"
+
+namespace ctl::graph {
+/*
+ * Square matrix of packed bits. Every row starts on a word boundary (rows are `stride` words apart), so a row can be
+ * handed to the state_set kernels as is. The capacity grows geometrically, which keeps adding states one by one
+ * amortized linear in the size of the matrix; reserve() avoids the regrowth altogether.
+ */
+class bit_matrix {
+public:
+  using word = state_set::word;
+
+  inline bit_matrix() = default;
+
+  [[nodiscard]] constexpr size_t size() const { return n; }
+  // Grows the matrix to size x size; the new rows and columns are empty.
+  void grow(size_t size);
+  void reserve(size_t size);
+
+  [[nodiscard]] inline bool test(size_t row, size_t col) const {
+    return (bits[row * stride + col / state_set::word_bits] >> (col % state_set::word_bits)) & 1;
+  }
+  inline void set(size_t row, size_t col) {
+    bits[row * stride + col / state_set::word_bits] |= word{1} << (col % state_set::word_bits);
+  }
+  [[nodiscard]] inline std::span<const word> row(size_t r) const {
+    return { bits.data() + r * stride, (n + state_set::word_bits - 1) / state_set::word_bits };
+  }
+
+private:
+  size_t n = 0;
+  size_t capacity = 0;
+  size_t stride = 0;
+  std::vector<word> bits;
+};
+}
+
+#endif //CTL_BIT_MATRIX_HPP
@@ -0,0 +1,135 @@
+//
+// Created by jay on 8/7/23.
+//
+
+#ifndef CTL_EXTERNAL_TS_HPP
+#define CTL_EXTERNAL_TS_HPP
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+#include "input_file.hpp"
+#include "graph/props.hpp"
+#include "graph/state_set.hpp"
+#include "graph/mapped_ts.hpp"
+
+namespace ctl::graph {
+/*
+ * Disk-resident TS over a binary TS file (see mapped_ts), for models whose edges don't fit in memory. Only the label
+ * columns and the initial/accepting states are loaded; the forward edges stay on disk and are streamed in blocks of
+ * consecutive states, each holding at most block_bytes of edges (a state with more edges gets a block of its own).
+ * A sweep reads the blocks it needs front to back (or back to front), so the I/O is sequential and its volume is
+ * known up front; the reverse edges are never read. Names are only read when printing.
+ * This is not a TS_view: there are no random-access successor lists. The semi-external checker in
+ * checker/external.hpp works on it through sweeps.
+ */
+class external_ts {
+public:
+  struct block {
+    size_t first; // first state
+    size_t last;  // one past the last state
+    std::uint64_t edges_begin;
+    std::uint64_t edges_end;
+  };
+
+  // The forward edges of one block, as read from disk.
+  class block_data {
+  public:
+    [[nodiscard]] inline std::span<const state_id> successors(size_t state) const {
+      const size_t i = state - first;
+      return { targets.data() + (offsets[i] - offsets[0]), offsets[i + 1] - offsets[i] };
+    }
+
+  private:
+    size_t first = 0;
+    std::vector<std::uint64_t> offsets;
+    std::vector<state_id> targets;
+
+    friend external_ts;
+  };
+
+  static constexpr size_t default_block_bytes = size_t{64} << 20;
+
+  explicit external_ts(const std::string &path, size_t block_bytes = default_block_bytes);
+
+  [[nodiscard]] inline size_t size() const { return hdr.states; }
+  [[nodiscard]] inline size_t edges() const { return hdr.edges; }
+  [[nodiscard]] inline const prop_table &propositions() const { return props; }
+  [[nodiscard]] inline const state_set &label(prop_id id) const { return labels[id]; }
+  [[nodiscard]] inline std::span<const size_t> initial() const { return initial_states; }
+  [[nodiscard]] inline std::span<const size_t> accepting() const { return accepting_states; }
+  [[nodiscard]] inline const std::vector<block> &blocks() const { return parts; }
+  [[nodiscard]] inline std::uint64_t bytes_read() const { return file.bytes_read(); }
+
+  // Reads the edges of b into out (reusing its buffers); throws a parse_error if they are corrupt.
+  void read(const block &b, block_data &out) const;
+
+  /*
+   * One pass over the edges: visit(s, successors of s) is called for every state s in `need`, in ascending (or with
+   * reverse, descending) order. Blocks without any state of `need` are skipped; the next block is prefetched while
+   * the current one is visited. Updates visit makes to `need` are seen by the rest of the sweep.
+   */
+  template <typename F>
+  void sweep(const state_set &need, bool reverse, F &&visit) const;
+
+  // Calls out(s, name of s) for every state in `states`, in ascending order; names are read in sequential chunks.
+  template <typename F>
+  void for_each_name(const state_set &states, F &&out) const;
+
+private:
+  // Whether any state in [first, last) is in s.
+  [[nodiscard]] static bool any_in(const state_set &s, size_t first, size_t last);
+  void prefetch(const block &b) const;
+  void read_names(size_t first, size_t last, std::vector<std::uint64_t> &offsets, std::string &chars) const;
+  template <typename T>
+  void read_section(std::uint64_t offset, std::uint64_t index, std::uint64_t count, T *dst) const;
+
+  input_file file;
+  mapped_ts::header hdr{};
+  std::vector<block> parts;
+  std::vector<state_set> labels;
+  std::vector<size_t> initial_states;
+  std::vector<size_t> accepting_states;
+  prop_table props;
+};
+
+template <typename F>
+void external_ts::sweep(const state_set &need, bool reverse, F &&visit) const {
+  std::vector<size_t> todo;
+  for(size_t k = 0; k < parts.size(); k++) {
+    const size_t b = reverse ? parts.size() - 1 - k : k;
+    if(any_in(need, parts[b].first, parts[b].last)) todo.push_back(b);
+  }
+
+  block_data data;
+  for(size_t k = 0; k < todo.size(); k++) {
+    const auto &b = parts[todo[k]];
+    read(b, data);
+    if(k + 1 < todo.size()) prefetch(parts[todo[k + 1]]);
+    for(size_t i = 0; i < b.last - b.first; i++) {
+      const size_t s = reverse ? b.last - 1 - i : b.first + i;
+      if(need.contains(s)) visit(s, data.successors(s));
+    }
+  }
+}
+
+template <typename F>
+void external_ts::for_each_name(const state_set &states, F &&out) const {
+  constexpr size_t chunk = size_t{1} << 16;
+  std::vector<std::uint64_t> offsets;
+  std::string chars;
+  for(size_t first = 0; first < size(); first += chunk) {
+    const size_t last = std::min(size(), first + chunk);
+    if(!any_in(states, first, last)) continue;
+    read_names(first, last, offsets, chars);
+    for(size_t s = first; s < last; s++) {
+      if(!states.contains(s)) continue;
+      out(s, std::string_view(chars).substr(offsets[s - first] - offsets[0], offsets[s - first + 1] - offsets[s - first]));
+    }
+  }
+}
+}
+
+#endif //CTL_EXTERNAL_TS_HPP
@@ -7,11 +7,15 @@
 
 #include <iostream>
 #include <stdexcept>
+#include <string>
 #include "ts.hpp"
 
 namespace ctl::graph {
 struct graph_reader {
   static default_ts parse(std::istream &strm);
+  // Same format and error messages as parse, but the file is memory-mapped and tokenized in place, in chunks of
+  // whole lines spread over `threads` threads. If the file contains several errors, the first one is reported.
+  static default_ts parse_file(const std::string &path, size_t threads = 1);
 };
 }
 
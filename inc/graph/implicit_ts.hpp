@@ -0,0 +1,124 @@
+//
+// Created by jay on 7/31/23.
+//
+
+#ifndef CTL_IMPLICIT_TS_HPP
+#define CTL_IMPLICIT_TS_HPP
+
+#include <vector>
+#include <cstdint>
+#include <ranges>
+#include <algorithm>
+#include <stdexcept>
+#include <concepts>
+#include <functional>
+#include <type_traits>
+#include "graph/ts.hpp"
+#include "graph/props.hpp"
+
+namespace ctl::graph {
+template <typename R, typename S>
+concept range_of = std::ranges::input_range<R> && std::convertible_to<std::ranges::range_value_t<R>, S>;
+
+/*
+ * An implicitly defined TS: instead of a materialized state space, it provides the initial states, a successor
+ * generator and a label evaluator over some compact state encoding (typically a few packed integers). States are only
+ * ever created while exploring, so the full state space never has to fit in memory.
+ */
+template <typename T>
+concept implicit_TS = requires(const T &ct, const typename T::state &s, const prop &p) {
+  requires std::is_trivially_copyable_v<typename T::state>;
+  requires std::equality_comparable<typename T::state>;
+  { std::hash<typename T::state>{}(s) } -> std::convertible_to<size_t>;
+  { ct.initial() } -> range_of<typename T::state>;
+  { ct.successors(s) } -> range_of<typename T::state>;
+  { ct.holds(s, p) } -> std::same_as<bool>;
+};
+
+/*
+ * Compact visited-state table: every distinct state is stored once, in discovery order, and gets a dense index.
+ * Lookup goes through an open-addressing (linear probing) table of 32-bit indices, so the overhead per state is a few
+ * bytes on top of the encoding itself (vs. a node allocation per state in std::unordered_map).
+ */
+template <typename S, typename H = std::hash<S>>
+class state_table {
+public:
+  using index = std::uint32_t;
+
+  // The index of s, adding it if it's new.
+  size_t intern(const S &s) {
+    if((states.size() + 1) * 2 > slots.size()) rehash(std::max<size_t>(16, slots.size() * 2));
+    const size_t mask = slots.size() - 1;
+    for(size_t i = spread(hasher(s)) & mask;; i = (i + 1) & mask) {
+      if(slots[i] == empty) {
+        slots[i] = (index)states.size();
+        states.push_back(s);
+        return states.size() - 1;
+      }
+      if(states[slots[i]] == s) return slots[i];
+    }
+  }
+
+  [[nodiscard]] inline const S &operator[](size_t i) const { return states[i]; }
+  [[nodiscard]] inline size_t size() const { return states.size(); }
+
+private:
+  static constexpr index empty = (index)-1;
+
+  // std::hash is the identity for integers, which clusters badly under linear probing
+  static inline size_t spread(size_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  void rehash(size_t capacity) {
+    if(capacity > (size_t)empty) throw std::length_error("state_table: too many states");
+    slots.assign(capacity, empty);
+    const size_t mask = capacity - 1;
+    for(size_t k = 0; k < states.size(); k++) {
+      size_t i = spread(hasher(states[k])) & mask;
+      while(slots[i] != empty) i = (i + 1) & mask;
+      slots[i] = (index)k;
+    }
+  }
+
+  std::vector<S> states;
+  std::vector<index> slots;
+  [[no_unique_address]] H hasher;
+};
+
+/*
+ * Presents an implicit TS as a state-indexed system to the local checker: states get an index the first time they're
+ * generated, and successors(i) expands state i on demand. Exploring is what discovers states, so the table is mutable
+ * even though the system itself doesn't change. Only forward edges are available.
+ */
+template <implicit_TS T>
+class lazy_ts {
+public:
+  using state = typename T::state;
+
+  explicit lazy_ts(const T &model) : model{model} {
+    for(const state &s: model.initial()) init.push_back(visited.intern(s));
+  }
+
+  [[nodiscard]] inline size_t size() const { return visited.size(); }
+  [[nodiscard]] inline const std::vector<size_t> &initial() const { return init; }
+  [[nodiscard]] std::vector<size_t> successors(size_t i) const {
+    std::vector<size_t> res;
+    const state s = visited[i];
+    for(const state &t: model.successors(s)) res.push_back(visited.intern(t));
+    return res;
+  }
+  [[nodiscard]] inline bool holds(size_t i, const prop &p) const { return model.holds(visited[i], p); }
+  [[nodiscard]] inline const state &operator[](size_t i) const { return visited[i]; }
+
+private:
+  const T &model;
+  mutable state_table<state> visited;
+  std::vector<size_t> init;
+};
+}
+
+#endif //CTL_IMPLICIT_TS_HPP
@@ -0,0 +1,185 @@
+//
+// Created by jay on 7/27/23.
+//
+
+#ifndef CTL_MAPPED_TS_HPP
+#define CTL_MAPPED_TS_HPP
+
+#include <span>
+#include <memory>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+#include <string_view>
+#include "mapped_file.hpp"
+#include "graph/ts.hpp"
+#include "graph/props.hpp"
+#include "graph/state_set.hpp"
+
+namespace ctl::graph {
+/*
+ * Read-only TS backed by a memory-mapped binary file (written by mapped_ts::save). Every section is laid out exactly
+ * as the checkers use it (CSR edge arrays in both directions, packed label columns, sorted initial/accepting states
+ * and a name pool), so opening a file only maps it and checks the header and section bounds; the states are never
+ * deserialized. Only the proposition table is rebuilt, which is tiny. The contents of the sections are trusted unless
+ * verify() is called.
+ * The file is written in native byte order; a byte-order mark in the header rejects files from the other endianness.
+ */
+class mapped_ts {
+public:
+  static constexpr char magic[8] = { 'C', 'T', 'L', 'T', 'S', 'B', 'I', 'N' };
+  static constexpr std::uint32_t format_version = 2;
+  static constexpr std::uint32_t byte_order = 0x01020304;
+
+  struct header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint64_t states;
+    std::uint64_t edges;
+    std::uint64_t props;
+    std::uint64_t initial;
+    std::uint64_t accepting;
+    std::uint64_t names_bytes;
+    // section offsets (in bytes, 8-byte aligned); edge targets are 32-bit state_ids, everything else is 64-bit
+    std::uint64_t fwd_offsets;
+    std::uint64_t fwd_targets;
+    std::uint64_t bwd_offsets;
+    std::uint64_t bwd_targets;
+    std::uint64_t labels;
+    std::uint64_t initial_states;
+    std::uint64_t accepting_states;
+    std::uint64_t name_offsets; // states + props + 1 entries: state names first, then proposition names
+    std::uint64_t names;
+  };
+
+  explicit mapped_ts(const std::string &path);
+  // Whether the file starts with the binary TS magic (as opposed to being a .gts text file).
+  static bool is_binary(const std::string &path);
+  // Throws a parse_error unless h is the header of a binary TS file this version can read, whose counts fit in a file of
+  // file_size bytes (so the section sizes derived from them can't overflow).
+  static void validate(const header &h, std::uint64_t file_size);
+  template <TS_view TS>
+  static void save(const TS &ts, const std::string &path);
+  // Throws a parse_error unless every offset array is monotone and every stored state is in range. This reads the
+  // whole file, so it's only done on request (for files from untrusted sources).
+  void verify() const;
+
+  [[nodiscard]] inline size_t size() const { return hdr->states; }
+  [[nodiscard]] inline std::span<const state_id> successors(size_t state) const {
+    return fwd_targets.subspan(fwd_offsets[state], fwd_offsets[state + 1] - fwd_offsets[state]);
+  }
+  [[nodiscard]] inline std::span<const state_id> predecessors(size_t state) const {
+    return bwd_targets.subspan(bwd_offsets[state], bwd_offsets[state + 1] - bwd_offsets[state]);
+  }
+  [[nodiscard]] inline std::string_view name(size_t state) const {
+    return names.substr(name_offsets[state], name_offsets[state + 1] - name_offsets[state]);
+  }
+  [[nodiscard]] inline const prop_table &propositions() const { return props; }
+  [[nodiscard]] inline state_set_view label(prop_id id) const {
+    return { label_words.subspan(id * words_per_label, words_per_label), size() };
+  }
+  [[nodiscard]] inline std::span<const size_t> initial() const { return initial_states; }
+  [[nodiscard]] inline std::span<const size_t> accepting() const { return accepting_states; }
+
+private:
+  // Streams the sections of a new file; the header is written last, once all offsets are known.
+  class writer {
+  public:
+    explicit writer(const std::string &path);
+    // Pads to the next 8-byte boundary and returns the offset of the section starting there.
+    std::uint64_t section();
+    void put(std::uint64_t v);
+    void put(std::uint32_t v);
+    void put(std::span<const std::uint64_t> vs);
+    void put(std::string_view s);
+    void finish(header h);
+
+  private:
+    std::ofstream out;
+    std::uint64_t pos = 0;
+  };
+
+  template <typename T>
+  std::span<const T> section(std::uint64_t offset, std::uint64_t count) const;
+
+  std::unique_ptr<mapped_file> file;
+  const header *hdr;
+  std::span<const size_t> fwd_offsets;
+  std::span<const state_id> fwd_targets;
+  std::span<const size_t> bwd_offsets;
+  std::span<const state_id> bwd_targets;
+  std::span<const state_set::word> label_words;
+  size_t words_per_label;
+  std::span<const size_t> initial_states;
+  std::span<const size_t> accepting_states;
+  std::span<const std::uint64_t> name_offsets;
+  std::string_view names;
+  prop_table props;
+};
+
+static_assert(TS_view<mapped_ts>);
+static_assert(sizeof(size_t) == sizeof(std::uint64_t), "the binary format stores states as 64-bit integers");
+
+template <TS_view TS>
+void mapped_ts::save(const TS &ts, const std::string &path) {
+  const size_t n = ts.size();
+  if(n > std::numeric_limits<state_id>::max()) throw std::runtime_error("too many states for the binary TS format");
+  const auto &table = ts.propositions();
+  writer out(path);
+  header h{};
+  std::copy(std::begin(magic), std::end(magic), h.magic);
+  h.version = format_version;
+  h.byte_order = byte_order;
+  h.states = n;
+  h.props = table.size();
+
+  auto put_csr = [&](std::uint64_t &offsets, std::uint64_t &targets, auto &&neighbours) {
+    offsets = out.section();
+    std::uint64_t total = 0;
+    out.put(total);
+    for(size_t s = 0; s < n; s++) {
+      for([[maybe_unused]] const size_t t: neighbours(s)) total++;
+      out.put(total);
+    }
+    targets = out.section();
+    for(size_t s = 0; s < n; s++) {
+      for(const size_t t: neighbours(s)) out.put((state_id)t);
+    }
+    return total;
+  };
+  h.edges = put_csr(h.fwd_offsets, h.fwd_targets, [&ts](size_t s) { return ts.successors(s); });
+  put_csr(h.bwd_offsets, h.bwd_targets, [&ts](size_t s) { return ts.predecessors(s); });
+
+  h.labels = out.section();
+  for(prop_id id = 0; id < table.size(); id++) out.put(state_set(ts.label(id).words(), n).words());
+
+  auto put_sorted = [&](std::uint64_t &count, auto &&states) {
+    std::vector<std::uint64_t> sorted(std::ranges::begin(states), std::ranges::end(states));
+    std::ranges::sort(sorted);
+    count = sorted.size();
+    const auto offset = out.section();
+    out.put(sorted);
+    return offset;
+  };
+  h.initial_states = put_sorted(h.initial, ts.initial());
+  h.accepting_states = put_sorted(h.accepting, ts.accepting());
+
+  h.name_offsets = out.section();
+  std::uint64_t name_end = 0;
+  out.put(name_end);
+  for(size_t s = 0; s < n; s++) out.put(name_end += std::string_view(ts.name(s)).size());
+  for(prop_id id = 0; id < table.size(); id++) out.put(name_end += table.name(id).size());
+  h.names_bytes = name_end;
+  h.names = out.section();
+  for(size_t s = 0; s < n; s++) out.put(std::string_view(ts.name(s)));
+  for(prop_id id = 0; id < table.size(); id++) out.put(std::string_view(table.name(id)));
+
+  out.finish(h);
+}
+}
+
+#endif //CTL_MAPPED_TS_HPP
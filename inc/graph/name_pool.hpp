@@ -0,0 +1,39 @@
+//
+// Created by jay on 8/6/23.
+//
+
+#ifndef CTL_NAME_POOL_HPP
+#define CTL_NAME_POOL_HPP
+
+#include <vector>
+#include <string>
+#include <string_view>
+
+namespace ctl::graph {
+// All state names of a TS back to back in a single buffer. Names are only needed for input and output, so they are
+// kept out of the per-state data the checkers walk over, and cost no allocation (or string header) per state.
+class name_pool {
+public:
+  inline size_t add(std::string_view name) {
+    chars.append(name);
+    ends.push_back(chars.size());
+    return ends.size() - 1;
+  }
+  inline void reserve(size_t names, size_t bytes) {
+    ends.reserve(names);
+    chars.reserve(bytes);
+  }
+
+  [[nodiscard]] inline std::string_view operator[](size_t i) const {
+    const size_t begin = i == 0 ? 0 : ends[i - 1];
+    return std::string_view(chars).substr(begin, ends[i] - begin);
+  }
+  [[nodiscard]] inline size_t size() const { return ends.size(); }
+
+private:
+  std::string chars;
+  std::vector<size_t> ends; // ends[i]: one past the last character of name i
+};
+}
+
+#endif //CTL_NAME_POOL_HPP
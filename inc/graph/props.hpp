@@ -0,0 +1,48 @@
+//
+// Created by jay on 7/11/23.
+//
+
+#ifndef CTL_PROPS_HPP
+#define CTL_PROPS_HPP
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include "graph/state_set.hpp"
+
+namespace ctl::graph {
+using prop = std::string;
+using prop_id = size_t;
+
+// Interns atomic propositions, so each distinct proposition is stored (and hashed) only once per TS.
+class prop_table {
+public:
+  static constexpr prop_id npos = (prop_id)-1;
+
+  prop_id intern(const prop &p);
+  [[nodiscard]] prop_id find(const prop &p) const;
+  [[nodiscard]] inline const prop &name(prop_id id) const { return names[id]; }
+  [[nodiscard]] inline size_t size() const { return names.size(); }
+
+private:
+  std::vector<prop> names;
+  std::unordered_map<prop, prop_id> ids;
+};
+
+// Stores the labelling function of a TS column-wise: one state set per interned proposition.
+class labelling {
+public:
+  void add(size_t state, const prop &p);
+  void remove(size_t state, const prop &p);
+  // Columns only grow up to the highest labelled state; callers should resize copies to the number of states.
+  [[nodiscard]] inline const state_set &column(prop_id id) const { return columns[id]; }
+  [[nodiscard]] inline const prop_table &table() const { return props; }
+  [[nodiscard]] std::vector<prop_id> of(size_t state) const;
+
+private:
+  prop_table props;
+  std::vector<state_set> columns;
+};
+}
+
+#endif //CTL_PROPS_HPP
@@ -0,0 +1,93 @@
+//
+// Created by jay on 8/4/23.
+//
+
+#ifndef CTL_REDUCTION_HPP
+#define CTL_REDUCTION_HPP
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include "graph/ts.hpp"
+#include "graph/state_set.hpp"
+
+namespace ctl::graph {
+/*
+ * A smaller TS to check instead of an original one, together with the state of the reduced TS each original state
+ * stands for. Results computed on the reduced TS are mapped back to the original states with lift().
+ */
+struct reduction {
+  static constexpr size_t npos = (size_t)-1;
+
+  sparse_ts ts;
+  std::vector<size_t> image; // image[s]: the reduced state standing for original state s (npos if s was dropped)
+
+  // The original states whose image is in s.
+  [[nodiscard]] state_set lift(const state_set &s) const;
+  // Number of original states the reduced TS accounts for.
+  [[nodiscard]] size_t kept() const;
+};
+
+// A reduction of the TS of first, as a reduction of the original TS of first.
+[[nodiscard]] reduction compose(const reduction &first, reduction second);
+
+// All states reachable from the initial states.
+template <TS_view TS>
+state_set reachable_states(const TS &ts) {
+  state_set res(ts.size());
+  std::vector<size_t> stack;
+  for(const size_t s: ts.initial()) {
+    if(res.contains(s)) continue;
+    res.insert(s);
+    stack.push_back(s);
+  }
+  while(!stack.empty()) {
+    const size_t v = stack.back();
+    stack.pop_back();
+    for(const size_t w: ts.successors(v)) {
+      if(res.contains(w)) continue;
+      res.insert(w);
+      stack.push_back(w);
+    }
+  }
+  return res;
+}
+
+/*
+ * Keeps only the states reachable from the initial states. They are renumbered densely in their original order, and
+ * keep their names, labels, edges and initial/accepting flags. No path from an initial state ever leaves the reachable
+ * part, so the verdict (and the satisfaction of every kept state) is the same as in the original TS.
+ */
+template <TS_view TS>
+reduction prune_unreachable(const TS &ts) {
+  const size_t n = ts.size();
+  const state_set keep = reachable_states(ts);
+  reduction res{ .ts = {}, .image = std::vector<size_t>(n, reduction::npos) };
+
+  state_set initial(n);
+  state_set accepting(n);
+  for(const size_t s: ts.initial()) initial.insert(s);
+  for(const size_t s: ts.accepting()) accepting.insert(s);
+  for(const size_t s: keep) {
+    res.image[s] = res.ts.add(ts.name(s), {}, initial.contains(s), accepting.contains(s));
+  }
+  for(const size_t s: keep) {
+    for(const size_t t: ts.successors(s)) res.ts.add_edge(res.image[s], res.image[t]);
+  }
+
+  const prop_table &props = ts.propositions();
+  for(prop_id id = 0; id < props.size(); id++) {
+    const std::span<const state_set::word> words = ts.label(id).words();
+    // label columns may be shorter than the number of states
+    const state_set_view column(words, std::min(n, words.size() * state_set::word_bits));
+    for(const size_t s: column) {
+      if(keep.contains(s)) res.ts.add_label(res.image[s], props.name(id));
+    }
+  }
+
+  res.ts.freeze();
+  return res;
+}
+}
+
+#endif //CTL_REDUCTION_HPP
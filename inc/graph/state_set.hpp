@@ -0,0 +1,122 @@
+//
+// Created by jay on 7/9/23.
+//
+
+#ifndef CTL_STATE_SET_HPP
+#define CTL_STATE_SET_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+#include <atomic>
+#include <span>
+
+namespace ctl::graph {
+/*
+ * Packed bitvector over the states of a transition system, indexed by node position.
+ * The bulk operations (intersection, union, difference, complement, emptiness, counting) run as word-wide kernels;
+ * the AVX2/AVX-512 variants are picked at runtime depending on what the CPU supports.
+ */
+class state_set {
+public:
+  using word = std::uint64_t;
+  static constexpr size_t word_bits = 64;
+
+  class iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const size_t *;
+    using reference = size_t;
+
+    inline iterator() = default;
+    inline iterator(const word *bits, size_t limit, size_t idx) : bits{bits}, limit{limit}, idx{idx} { seek(); }
+    constexpr size_t operator*() const { return idx; }
+    inline iterator &operator++() { ++idx; seek(); return *this; }
+    inline iterator operator++(int) { auto cp = *this; ++*this; return cp; }
+    constexpr bool operator==(const iterator &other) const { return idx == other.idx; }
+
+  private:
+    void seek();
+
+    const word *bits = nullptr;
+    size_t limit = 0;
+    size_t idx = 0;
+  };
+
+  inline state_set() = default;
+  explicit state_set(size_t size, bool value = false);
+  // Copies packed words (e.g. a label column that may be shorter or longer than size); missing words are zero.
+  state_set(std::span<const word> words, size_t size);
+
+  [[nodiscard]] constexpr size_t size() const { return n; }
+  [[nodiscard]] inline bool contains(size_t i) const { return (bits[i / word_bits] >> (i % word_bits)) & 1; }
+  inline void insert(size_t i) { bits[i / word_bits] |= word{1} << (i % word_bits); }
+  inline void erase(size_t i) { bits[i / word_bits] &= ~(word{1} << (i % word_bits)); }
+  // Thread-safe variants, for sets shared between the workers of a parallel fixpoint. atomic_insert returns whether i
+  // was newly inserted by this call.
+  [[nodiscard]] inline bool atomic_contains(size_t i) const {
+    return (std::atomic_ref<word>(const_cast<word &>(bits[i / word_bits])).load(std::memory_order_relaxed) >> (i % word_bits)) & 1;
+  }
+  inline bool atomic_insert(size_t i) {
+    const word mask = word{1} << (i % word_bits);
+    return !(std::atomic_ref<word>(bits[i / word_bits]).fetch_or(mask, std::memory_order_relaxed) & mask);
+  }
+  void resize(size_t size);
+  void clear();
+
+  [[nodiscard]] bool empty() const;
+  [[nodiscard]] size_t count() const;
+  [[nodiscard]] bool intersects(const state_set &other) const;
+  // Word-level variants for rows of packed bits stored elsewhere (e.g. a bit_matrix); words past size() are ignored.
+  [[nodiscard]] bool intersects(std::span<const word> other) const;
+  void unite(std::span<const word> other);
+  void flip();
+
+  state_set &operator&=(const state_set &other);
+  state_set &operator|=(const state_set &other);
+  state_set &operator-=(const state_set &other);
+  [[nodiscard]] bool operator==(const state_set &other) const;
+
+  [[nodiscard]] inline iterator begin() const { return { bits.data(), n, 0 }; }
+  [[nodiscard]] inline iterator end() const { return { bits.data(), n, n }; }
+
+  [[nodiscard]] constexpr const std::vector<word> &words() const { return bits; }
+
+private:
+  void trim();
+
+  size_t n = 0;
+  std::vector<word> bits;
+};
+
+// Non-owning, read-only view of packed words laid out like a state_set (e.g. a label column inside a mapped file).
+class state_set_view {
+public:
+  using word = state_set::word;
+
+  inline state_set_view() = default;
+  inline state_set_view(std::span<const word> words, size_t size) : w{words}, n{size} {}
+
+  [[nodiscard]] constexpr size_t size() const { return n; }
+  [[nodiscard]] inline bool contains(size_t i) const {
+    return i < n && ((w[i / state_set::word_bits] >> (i % state_set::word_bits)) & 1);
+  }
+  [[nodiscard]] inline state_set::iterator begin() const { return { w.data(), n, 0 }; }
+  [[nodiscard]] inline state_set::iterator end() const { return { w.data(), n, n }; }
+  [[nodiscard]] constexpr std::span<const word> words() const { return w; }
+
+private:
+  std::span<const word> w;
+  size_t n = 0;
+};
+
+[[nodiscard]] state_set operator&(state_set one, const state_set &other);
+[[nodiscard]] state_set operator|(state_set one, const state_set &other);
+[[nodiscard]] state_set operator-(state_set one, const state_set &other);
+[[nodiscard]] state_set operator~(state_set one);
+}
+
+#endif //CTL_STATE_SET_HPP
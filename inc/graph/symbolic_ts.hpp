@@ -0,0 +1,110 @@
+//
+// Created by jay on 7/25/23.
+//
+
+#ifndef CTL_SYMBOLIC_TS_HPP
+#define CTL_SYMBOLIC_TS_HPP
+
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include "bdd/bdd.hpp"
+#include "graph/ts.hpp"
+#include "graph/props.hpp"
+
+namespace ctl::graph {
+/*
+ * Symbolic TS: states are bit vectors of a fixed width, and the sets of initial states, valid states, labels and the
+ * transition relation are all BDDs. Current-state bit i is BDD variable 2i and its next-state copy is variable 2i + 1;
+ * interleaving both copies keeps the transition relation of most regular models small.
+ * Bit 0 is the most significant bit of a state's code.
+ */
+class symbolic_ts {
+public:
+  using set_t = bdd::bdd;
+
+  symbolic_ts(bdd::manager &mgr, size_t bits);
+
+  [[nodiscard]] inline size_t bits() const { return nbits; }
+  [[nodiscard]] inline bdd::manager &manager() const { return *mgr; }
+  [[nodiscard]] set_t cur(size_t bit) const;
+  [[nodiscard]] set_t next(size_t bit) const;
+  // The (current- or next-state) cube of a single state code.
+  [[nodiscard]] set_t encode(std::uint64_t code, bool primed = false) const;
+
+  void add_initial(const set_t &states);
+  // rel ranges over both current- and next-state variables.
+  void add_transitions(const set_t &rel);
+  void add_label(const prop &p, const set_t &states);
+  // Restricts the state space to a subset of all codes (e.g. when the number of states isn't a power of two).
+  void restrict_states(const set_t &states);
+
+  [[nodiscard]] inline const set_t &initial() const { return init; }
+  [[nodiscard]] inline const set_t &transitions() const { return trans; }
+  [[nodiscard]] inline const set_t &states() const { return valid; }
+  [[nodiscard]] set_t label(const prop &p) const;
+
+  // States with a successor in s: exists x' . T(x, x') /\ s(x').
+  [[nodiscard]] set_t pre_image(const set_t &s) const;
+  // States with a predecessor in s: exists x . s(x) /\ T(x, x').
+  [[nodiscard]] set_t post_image(const set_t &s) const;
+  [[nodiscard]] double count(const set_t &s) const;
+  [[nodiscard]] bool contains(const set_t &s, std::uint64_t code) const;
+
+  template <TS_view TS>
+  static symbolic_ts from_explicit(bdd::manager &mgr, const TS &ts);
+
+private:
+  // Balanced disjunction, which keeps the intermediate BDDs much smaller than a left fold.
+  set_t disjunction(std::vector<set_t> parts) const;
+  // All codes strictly below n.
+  set_t codes_below(std::uint64_t n) const;
+
+  bdd::manager *mgr;
+  size_t nbits;
+  std::vector<bdd::var_t> cur_vars;
+  std::vector<bdd::var_t> next_vars;
+  std::vector<bdd::var_t> to_next;
+  std::vector<bdd::var_t> to_cur;
+  set_t cur_cube;
+  set_t next_cube;
+  set_t init;
+  set_t trans;
+  set_t valid;
+  std::unordered_map<prop, set_t> labels;
+};
+
+template <TS_view TS>
+symbolic_ts symbolic_ts::from_explicit(bdd::manager &mgr, const TS &ts) {
+  const size_t n = ts.size();
+  size_t bits = 1;
+  while(bits < 64 && (std::uint64_t{1} << bits) < n) bits++;
+
+  symbolic_ts res(mgr, bits);
+  res.restrict_states(res.codes_below(n));
+
+  std::vector<set_t> parts;
+  for(size_t v = 0; v < n; v++) {
+    std::vector<set_t> succ;
+    for(const size_t s: ts.successors(v)) succ.push_back(res.encode(s, true));
+    if(succ.empty()) continue;
+    parts.push_back(res.encode(v) & res.disjunction(std::move(succ)));
+  }
+  res.add_transitions(res.disjunction(std::move(parts)));
+
+  std::vector<set_t> initial;
+  for(const size_t s: ts.initial()) initial.push_back(res.encode(s));
+  res.add_initial(res.disjunction(std::move(initial)));
+
+  const auto &props = ts.propositions();
+  for(prop_id id = 0; id < props.size(); id++) {
+    std::vector<set_t> states;
+    for(const auto s: state_set(ts.label(id).words(), n)) states.push_back(res.encode(s));
+    res.add_label(props.name(id), res.disjunction(std::move(states)));
+  }
+
+  return res;
+}
+}
+
+#endif //CTL_SYMBOLIC_TS_HPP
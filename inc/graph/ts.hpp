@@ -8,28 +8,64 @@
 #include <vector>
 #include <string>
 #include <concepts>
+#include <ranges>
+#include <span>
+#include <string_view>
 #include <unordered_set>
+#include <utility>
+#include <cstdint>
+#include "graph/props.hpp"
+#include "graph/name_pool.hpp"
+#include "graph/state_set.hpp"
+#include "graph/bit_matrix.hpp"
+
+namespace ctl {
+class thread_pool;
+}
 
 namespace ctl::graph {
-using prop = std::string;
+// States are stored as 32-bit indices in the adjacency lists and the checkers' work lists, which halves the memory
+// traffic of the fixpoint loops. A sparse_ts or dense_ts holds at most max_states states.
+using state_id = std::uint32_t;
+constexpr size_t max_states = (size_t)UINT32_MAX;
+
+template <typename R>
+concept state_range = std::ranges::forward_range<R> && std::convertible_to<std::ranges::range_value_t<R>, size_t>;
+
 template <typename N>
-concept TS_node = requires(const typename N::ts_t &ts, N node, const N &cn, std::string p) {
-  { node.name() } -> std::same_as<const std::string &>;
-  { node.props() } -> std::same_as<const std::unordered_set<prop> &>;
-  { cn.post_in(ts) } -> std::same_as<std::vector<const N *>>;
-  { cn.pre_in(ts) } -> std::same_as<std::vector<const N *>>;
-  { node.add_prop(p) } -> std::same_as<void>;
+concept TS_node = requires(const typename N::ts_t &ts, const N &cn) {
+  { cn.name(ts) } -> std::convertible_to<std::string_view>;
+  { cn.index() } -> std::same_as<size_t>;
+  { cn.successors(ts) } -> state_range;
+  { cn.predecessors(ts) } -> state_range;
 };
 
+// Read-only, state-indexed access to a TS. This is all the checkers need, so it can also be backed by something that
+// isn't a TS in memory (like a mapped file).
 template <typename T>
-concept TS = requires(std::string &&n, std::unordered_set<prop> &&p, size_t s, T t, const T &ct, bool init) {
+concept TS_view = requires(const T &ct, size_t s, prop_id id) {
+  { ct.size() } -> std::same_as<size_t>;
+  { ct.successors(s) } -> state_range;
+  { ct.predecessors(s) } -> state_range;
+  { ct.name(s) } -> std::convertible_to<std::string_view>;
+  { ct.propositions() } -> std::same_as<const prop_table &>;
+  { ct.label(id).words() } -> std::convertible_to<std::span<const state_set::word>>;
+  { ct.initial() } -> state_range;
+  { ct.accepting() } -> state_range;
+};
+
+template <typename T>
+concept TS = requires(std::string_view n, std::unordered_set<prop> &&p, const prop &ap, prop_id id, size_t s, T t, const T &ct, bool init) {
   requires std::default_initializable<T>;
+  requires TS_view<T>;
   requires TS_node<typename T::node>;
-  { t.add(std::move(n), std::move(p), init, false) } -> std::same_as<size_t>;
+  { t.add(n, std::move(p), init, false) } -> std::same_as<size_t>;
   { t.add_transition(s, s) } -> std::same_as<void>;
+  { t.add_label(s, ap) } -> std::same_as<void>;
+  { ct.propositions() } -> std::same_as<const prop_table &>;
+  { ct.label(id) } -> std::same_as<const state_set &>;
   { t.all_nodes() } -> std::same_as<std::vector<typename T::node>>;
   { ct.all_nodes() } -> std::same_as<const std::vector<typename T::node> &>;
-  { ct.initial_nodes() } -> std::same_as<std::unordered_set<const typename T::node *>>;
 };
 
 class dense_ts;
@@ -40,38 +76,79 @@ public:
   public:
     using ts_t = sparse_ts;
 
-    inline node(std::string &&name, std::unordered_set<prop> &&prop) : nm{std::move(name)}, ap{std::move(prop)} {}
-    [[nodiscard]] constexpr const std::string &name() const { return nm; }
-    [[nodiscard]] constexpr const std::unordered_set<prop> &props() const { return ap; }
-    [[nodiscard]] std::vector<const node *> post_in(const sparse_ts &ts) const;
-    [[nodiscard]] std::vector<const node *> pre_in(const sparse_ts &ts) const;
-    inline void add_prop(const prop &p) { ap.insert(p); }
+    inline explicit node(size_t idx) : idx{(state_id)idx} {}
+    [[nodiscard]] inline std::string_view name(const sparse_ts &ts) const { return ts.names[idx]; }
+    [[nodiscard]] constexpr size_t index() const { return idx; }
+    [[nodiscard]] inline std::span<const state_id> successors(const sparse_ts &ts) const;
+    [[nodiscard]] inline std::span<const state_id> predecessors(const sparse_ts &ts) const;
 
   private:
-    std::string nm;
-    std::unordered_set<prop> ap;
-    std::vector<size_t> transitions;
-    std::vector<size_t> incoming_transitions;
+    state_id idx;
+    std::vector<state_id> transitions;
+    std::vector<state_id> incoming_transitions;
 
     friend sparse_ts;
   };
 
   inline sparse_ts() = default;
-  size_t add(std::string &&name, std::unordered_set<prop> &&ap, bool is_initial, bool is_accepting);
+  size_t add(std::string_view name, std::unordered_set<prop> &&ap, bool is_initial, bool is_accepting);
   void add_transition(size_t start, size_t end);
+  void remove_transition(size_t start, size_t end);
+  inline void add_label(size_t state, const prop &p) { labels.add(state, p); }
+  inline void remove_label(size_t state, const prop &p) { labels.remove(state, p); }
   constexpr std::vector<node> all_nodes() { return nodes; }
   constexpr const std::vector<node> &all_nodes() const { return nodes; }
-  std::unordered_set<const node *> initial_nodes() const;
+
+  // Bulk construction: add_edge only queues the edge (in constant time, duplicates allowed). Queued edges aren't
+  // visible until the next freeze(), which sorts, deduplicates and lays them out together with the existing ones.
+  inline void add_edge(size_t start, size_t end) { raw_edges.emplace_back((state_id)start, (state_id)end); }
+  inline void reserve_edges(size_t count) { raw_edges.reserve(raw_edges.size() + count); }
+
+  [[nodiscard]] inline const prop_table &propositions() const { return labels.table(); }
+  [[nodiscard]] inline const state_set &label(prop_id id) const { return labels.column(id); }
+
+  [[nodiscard]] inline size_t size() const { return nodes.size(); }
+  [[nodiscard]] inline std::span<const state_id> successors(size_t state) const { return nodes[state].successors(*this); }
+  [[nodiscard]] inline std::span<const state_id> predecessors(size_t state) const { return nodes[state].predecessors(*this); }
+  [[nodiscard]] inline std::string_view name(size_t state) const { return names[state]; }
+  [[nodiscard]] inline const std::unordered_set<size_t> &initial() const { return initial_states; }
+  [[nodiscard]] inline const std::unordered_set<size_t> &accepting() const { return accepting_states; }
+
+  // Freezing moves the adjacency lists (and the queued edges) into compressed-sparse-row arrays, in time linear in the
+  // number of edges and spread over the pool if one is given; modifying the TS afterwards thaws it again.
+  void freeze(thread_pool *pool = nullptr);
+  [[nodiscard]] constexpr bool frozen() const { return is_frozen; }
 
   [[nodiscard]] dense_ts make_dense() const;
   void dump() const;
 
 private:
+  void thaw();
+
   std::vector<node> nodes;
+  name_pool names;
+  labelling labels;
   std::unordered_set<size_t> initial_states;
   std::unordered_set<size_t> accepting_states;
+
+  std::vector<std::pair<state_id, state_id>> raw_edges;
+  bool is_frozen = false;
+  std::vector<size_t> fwd_offsets;
+  std::vector<state_id> fwd_targets;
+  std::vector<size_t> bwd_offsets;
+  std::vector<state_id> bwd_targets;
 };
 
+std::span<const state_id> sparse_ts::node::successors(const sparse_ts &ts) const {
+  if(!ts.is_frozen) return transitions;
+  return { ts.fwd_targets.data() + ts.fwd_offsets[idx], ts.fwd_offsets[idx + 1] - ts.fwd_offsets[idx] };
+}
+
+std::span<const state_id> sparse_ts::node::predecessors(const sparse_ts &ts) const {
+  if(!ts.is_frozen) return incoming_transitions;
+  return { ts.bwd_targets.data() + ts.bwd_offsets[idx], ts.bwd_offsets[idx + 1] - ts.bwd_offsets[idx] };
+}
+
 static_assert(TS_node<sparse_ts::node>);
 static_assert(TS<sparse_ts>);
 
@@ -80,39 +157,74 @@ public:
   class node {
   public:
     using ts_t = dense_ts;
-    inline node(std::string &&name, std::unordered_set<prop> &&prop, size_t idx) : nm{std::move(name)}, ap{std::move(prop)}, idx{idx} {}
-    [[nodiscard]] constexpr const std::string &name() const { return nm; }
-    [[nodiscard]] constexpr const std::unordered_set<prop> &props() const { return ap; }
-    [[nodiscard]] std::vector<const node *> post_in(const dense_ts &ts) const;
-    [[nodiscard]] std::vector<const node *> pre_in(const dense_ts &ts) const;
-    inline void add_prop(const prop &p) { ap.insert(p); }
+    inline explicit node(size_t idx) : idx{(state_id)idx} {}
+    [[nodiscard]] inline std::string_view name(const dense_ts &ts) const { return ts.names[idx]; }
+    [[nodiscard]] constexpr size_t index() const { return idx; }
+    [[nodiscard]] inline state_set_view successors(const dense_ts &ts) const;
+    [[nodiscard]] inline state_set_view predecessors(const dense_ts &ts) const;
   private:
 
-    std::string nm;
-    std::unordered_set<prop> ap;
-    size_t idx;
+    state_id idx;
   };
 
   inline dense_ts() = default;
-  size_t add(std::string &&name, std::unordered_set<prop> &&ap, bool is_initial, bool is_accepting);
+  // Bulk building: makes room for `states` states up front, so the matrices are allocated exactly once.
+  void reserve(size_t states);
+  size_t add(std::string_view name, std::unordered_set<prop> &&ap, bool is_initial, bool is_accepting);
   void add_transition(size_t start, size_t end);
+  inline void add_label(size_t state, const prop &p) { labels.add(state, p); }
   constexpr std::vector<node> all_nodes() { return nodes; }
   constexpr const std::vector<node> &all_nodes() const { return nodes; }
-  std::unordered_set<const node *> initial_nodes() const;
+  [[nodiscard]] inline const prop_table &propositions() const { return labels.table(); }
+  [[nodiscard]] inline const state_set &label(prop_id id) const { return labels.column(id); }
+
+  [[nodiscard]] inline size_t size() const { return nodes.size(); }
+  [[nodiscard]] inline state_set_view successors(size_t state) const { return { fwd.row(state), nodes.size() }; }
+  [[nodiscard]] inline state_set_view predecessors(size_t state) const { return { bwd.row(state), nodes.size() }; }
+  [[nodiscard]] inline std::string_view name(size_t state) const { return names[state]; }
+  [[nodiscard]] inline const std::unordered_set<size_t> &initial() const { return initial_states; }
+  [[nodiscard]] inline const std::unordered_set<size_t> &accepting() const { return accepting_states; }
+
+  // Word-parallel boolean matrix-vector products: the states with a successor (resp. predecessor) in s.
+  [[nodiscard]] state_set pre_image(const state_set &s) const;
+  [[nodiscard]] state_set post_image(const state_set &s) const;
 
   [[nodiscard]] sparse_ts make_sparse() const;
   void dump() const;
 
 private:
+  // {i | m[i] intersects s}, where t is the transpose of m: either a union of the rows of t selected by s (for small
+  // s) or an intersection test against every row of m.
+  [[nodiscard]] state_set image(const bit_matrix &m, const bit_matrix &t, const state_set &s) const;
+
   std::vector<node> nodes;
+  name_pool names;
+  labelling labels;
   std::unordered_set<size_t> initial_states;
   std::unordered_set<size_t> accepting_states;
-  std::vector<std::vector<bool>> transitions;
+  // fwd[i][j] iff i -> j; bwd is its transpose
+  bit_matrix fwd;
+  bit_matrix bwd;
 };
 
+state_set_view dense_ts::node::successors(const dense_ts &ts) const {
+  return ts.successors(idx);
+}
+
+state_set_view dense_ts::node::predecessors(const dense_ts &ts) const {
+  return ts.predecessors(idx);
+}
+
 static_assert(TS_node<dense_ts::node>);
 static_assert(TS<dense_ts>);
 
+// TSs that can compute the pre- and post-image of a whole state set at once, rather than state by state.
+template <typename T>
+concept image_TS = TS_view<T> && requires(const T &ct, const state_set &s) {
+  { ct.pre_image(s) } -> std::same_as<state_set>;
+  { ct.post_image(s) } -> std::same_as<state_set>;
+};
+
 using default_ts = sparse_ts;
 }
 
@@ -0,0 +1,35 @@
+//
+// Created by jay on 8/7/23.
+//
+
+#ifndef CTL_INPUT_FILE_HPP
+#define CTL_INPUT_FILE_HPP
+
+#include <string>
+#include <cstdint>
+
+namespace ctl {
+// Read-only file accessed with positional reads instead of a mapping, for data that is streamed through a bounded
+// buffer rather than kept (or paged) in memory. Counts the bytes read, so callers can report their I/O volume.
+class input_file {
+public:
+  explicit input_file(const std::string &path);
+  input_file(const input_file &) = delete;
+  input_file &operator=(const input_file &) = delete;
+  ~input_file();
+
+  [[nodiscard]] inline std::uint64_t size() const { return len; }
+  [[nodiscard]] inline std::uint64_t bytes_read() const { return total; }
+  // Reads exactly `bytes` bytes starting at `offset` into dst; throws if the file ends early or the read fails.
+  void read(void *dst, std::uint64_t bytes, std::uint64_t offset) const;
+  // Hints that [offset, offset + bytes) will be read soon, so the kernel can start fetching it in the background.
+  void will_need(std::uint64_t offset, std::uint64_t bytes) const;
+
+private:
+  int fd = -1;
+  std::uint64_t len = 0;
+  mutable std::uint64_t total = 0;
+};
+}
+
+#endif //CTL_INPUT_FILE_HPP
@@ -0,0 +1,30 @@
+//
+// Created by jay on 7/26/23.
+//
+
+#ifndef CTL_MAPPED_FILE_HPP
+#define CTL_MAPPED_FILE_HPP
+
+#include <string>
+#include <string_view>
+
+namespace ctl {
+// Read-only memory mapping of a whole file; the contents stay valid for the lifetime of the object.
+class mapped_file {
+public:
+  explicit mapped_file(const std::string &path);
+  mapped_file(const mapped_file &) = delete;
+  mapped_file &operator=(const mapped_file &) = delete;
+  ~mapped_file();
+
+  [[nodiscard]] inline const char *data() const { return ptr; }
+  [[nodiscard]] inline size_t size() const { return len; }
+  [[nodiscard]] inline std::string_view view() const { return { ptr, len }; }
+
+private:
+  const char *ptr = nullptr;
+  size_t len = 0;
+};
+}
+
+#endif //CTL_MAPPED_FILE_HPP
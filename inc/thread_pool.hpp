@@ -0,0 +1,110 @@
+//
+// Created by jay on 7/18/23.
+//
+
+#ifndef CTL_THREAD_POOL_HPP
+#define CTL_THREAD_POOL_HPP
+
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <condition_variable>
+
+namespace ctl {
+class thread_pool {
+public:
+  // Creates a pool with `threads - 1` workers; the thread calling parallel_for always participates as well.
+  explicit thread_pool(size_t threads);
+  thread_pool(const thread_pool &) = delete;
+  thread_pool &operator=(const thread_pool &) = delete;
+  ~thread_pool();
+
+  [[nodiscard]] inline size_t size() const { return workers.size() + 1; }
+  void submit(std::function<void()> task);
+  // Runs queued tasks on the calling thread until done() holds. Whatever makes done() true has to call wake() afterwards.
+  template <typename P>
+  void help_until(P &&done);
+  void wake();
+
+  /*
+   * Runs fn(0), ..., fn(count - 1) on the calling thread and the workers. The chunk range is split evenly over the
+   * participants; a participant that runs out of chunks steals single chunks from the others.
+   * Returns once every chunk has finished. Never blocks on a worker being available, so this is safe to call from
+   * within a task running on the pool itself.
+   */
+  template <typename F>
+  void parallel_for(size_t count, F &&fn);
+
+private:
+  struct range {
+    alignas(64) std::atomic<size_t> next;
+    size_t end;
+  };
+
+  struct loop_state {
+    std::vector<range> ranges;
+    std::atomic<size_t> remaining;
+    std::function<void(size_t)> fn;
+  };
+
+  static void participate(loop_state &state, size_t self);
+  void work();
+
+  std::vector<std::thread> workers;
+  std::deque<std::function<void()>> tasks;
+  std::mutex mtx;
+  std::condition_variable cv;
+  bool stopping = false;
+};
+
+template <typename P>
+void thread_pool::help_until(P &&done) {
+  while(true) {
+    std::function<void()> task;
+    {
+      std::unique_lock lock(mtx);
+      cv.wait(lock, [this, &done]() { return done() || !tasks.empty(); });
+      if(done()) return;
+      task = std::move(tasks.front());
+      tasks.pop_front();
+    }
+    task();
+  }
+}
+
+template <typename F>
+void thread_pool::parallel_for(size_t count, F &&fn) {
+  if(count == 0) return;
+  const size_t participants = std::min(size(), count);
+  if(participants == 1) {
+    for(size_t i = 0; i < count; i++) fn(i);
+    return;
+  }
+
+  auto state = std::make_shared<loop_state>();
+  state->ranges = std::vector<range>(participants);
+  for(size_t p = 0; p < participants; p++) {
+    state->ranges[p].next = count * p / participants;
+    state->ranges[p].end = count * (p + 1) / participants;
+  }
+  state->remaining = count;
+  state->fn = [&fn](size_t i) { fn(i); };
+
+  // helpers only hold on to the shared state; they touch fn only after claiming a chunk, which keeps us waiting below
+  for(size_t p = 1; p < participants; p++) {
+    submit([state, p]() { participate(*state, p); });
+  }
+  participate(*state, 0);
+
+  for(size_t left = state->remaining.load(); left != 0; left = state->remaining.load()) {
+    state->remaining.wait(left);
+  }
+}
+}
+
+#endif //CTL_THREAD_POOL_HPP
@@ -1,36 +1,180 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <string_view>
+#include <thread>
+#include <cstdlib>
+#include <optional>
+#include <cstdint>
+#include <charconv>
+#include "util.hpp"
 #include "graph/graph_reader.hpp"
 #include "formula/formula_parser.hpp"
+#include "formula/formula_dag.hpp"
 #include "checker/checker.hpp"
+#include "checker/symbolic.hpp"
+#include "checker/local.hpp"
+#include "checker/external.hpp"
+#include "graph/symbolic_ts.hpp"
+#include "graph/mapped_ts.hpp"
+#include "graph/reduction.hpp"
+#include "graph/bisimulation.hpp"
+#include "graph/external_ts.hpp"
 
-int main(int argc, const char **argv) {
-  if(argc < 3) {
-    std::cerr << "Usage: " << argv[0] << " <input graph file> <input formula file>\n";
-    return -1;
-  }
+using clk = std::chrono::steady_clock;
 
-  std::ifstream strm(argv[1]);
-  if(!strm.good()) {
-    std::cerr << "Error: can't open file " << argv[1] << " for reading.\n";
-    return -2;
+double ms_since(clk::time_point start) {
+  return std::chrono::duration<double, std::milli>(clk::now() - start).count();
+}
+
+// check_all(dag, roots, report) has to call report(k, verdict, |SAT|) once for every root (|SAT| may be unknown).
+template <typename F>
+int run_batch(std::istream &strm, const char *file, F &&check_all) {
+  // one formula per line (or several, separated by `;'); empty lines and `// ' comments are skipped
+  std::vector<std::string> texts;
+  std::vector<size_t> lines;
+  std::string line;
+  for(size_t lineno = 1; std::getline(strm, line); lineno++) {
+    if(line.starts_with("//")) continue;
+    for(const auto &part: ctl::split_by(line, ';')) {
+      auto text = ctl::strip(part);
+      if(text.empty()) continue;
+      texts.push_back(text);
+      lines.push_back(lineno);
+    }
   }
 
-  ctl::graph::default_ts ts;
-  try {
-    ts = ctl::graph::graph_reader::parse(strm);
+  ctl::formula::formula_dag dag;
+  std::vector<ctl::formula::formula_dag::id> roots;
+  for(size_t i = 0; i < texts.size(); i++) {
+    std::istringstream buf(texts[i]);
+    try {
+      roots.push_back(dag.intern(ctl::formula::parser::parse(buf)));
+    }
+    catch(const std::exception &exc) {
+      std::cerr << "Error while parsing " << file << " (at line " << lines[i] << "): " << exc.what() << "\n";
+      return -3;
+    }
   }
-  catch(const std::exception &exc) {
-    std::cerr << "Error while parsing: " << exc.what() << "\n";
-    return -3;
+
+  std::cout << std::setw(6) << "#" << "  " << std::setw(7) << "result" << "  " << std::setw(10) << "|SAT|" << "  "
+            << std::setw(10) << "time (ms)" << "  formula\n";
+
+  size_t holds = 0;
+  auto start = clk::now();
+  auto last = start;
+  check_all(dag, roots, [&](size_t k, bool verdict, std::optional<double> count) {
+    double elapsed = ms_since(last);
+    if(verdict) holds++;
+    std::cout << std::setw(6) << k + 1 << "  " << std::setw(7) << (verdict ? "holds" : "fails") << "  "
+              << std::setw(10) << std::fixed << std::setprecision(0);
+    if(count) std::cout << *count;
+    else std::cout << "-";
+    std::cout << "  " << std::setw(10) << std::setprecision(3) << elapsed << "  " << texts[k] << "\n";
+    last = clk::now();
+  });
+
+  std::cout << roots.size() << " formulas (" << dag.size() << " unique subformulas), " << holds << " hold; checked in "
+            << std::fixed << std::setprecision(3) << ms_since(start) << " ms\n";
+  return 0;
+}
+
+struct options {
+  bool batch = false;
+  bool symbolic = false;
+  bool local = false;
+  bool fair = false;
+  bool prune_unreachable = false;
+  bool bisim = false;
+  bool external = false;
+  bool verify = false;
+  size_t block_bytes = ctl::graph::external_ts::default_block_bytes;
+  size_t threads = 1;
+  ctl::checker::sat_calc::eg_engine eg = ctl::checker::sat_calc::eg_engine::COUNTING;
+  const char *save_binary = nullptr;
+  const char *stats = nullptr;
+  const char *trace = nullptr;
+};
+
+// The states (out of the first n codes) of a symbolic TS in sat, as an explicit set.
+ctl::graph::state_set explicit_set(const ctl::graph::symbolic_ts &sym, const ctl::bdd::bdd &sat, size_t n) {
+  ctl::graph::state_set res(n);
+  for(size_t idx = 0; idx < n; idx++) {
+    if(sym.contains(sat, idx)) res.insert(idx);
   }
+  return res;
+}
 
-  strm = std::ifstream(argv[2]);
+// Writes the profile to the files requested with --stats/--trace.
+int write_profile(const ctl::checker::profiler &prof, const options &opts) {
+  auto write = [](const char *file, auto &&writer) {
+    std::ofstream out(file);
+    writer(out);
+    if(out.good()) return true;
+    std::cerr << "Error: can't write " << file << "\n";
+    return false;
+  };
+  bool ok = true;
+  if(opts.stats != nullptr) ok &= write(opts.stats, [&prof](std::ostream &out) { prof.write_json(out); });
+  if(opts.trace != nullptr) ok &= write(opts.trace, [&prof](std::ostream &out) { prof.write_trace(out); });
+  return ok ? 0 : -2;
+}
+
+// Checks the formula(s) in formula_file on ts. If red is set, ts is a reduction of orig, and results are reported in terms
+// of the states of orig.
+template <ctl::graph::TS_view TS, ctl::graph::TS_view Orig>
+int check(const TS &ts, const Orig &orig, const ctl::graph::reduction *red, double load_time, const char *formula_file,
+          const options &opts) {
+  std::ifstream strm(formula_file);
   if(!strm.good()) {
-    std::cerr << "Error: can't open file " << argv[2] << " for reading.\n";
+    std::cerr << "Error: can't open file " << formula_file << " for reading.\n";
     return -2;
   }
 
+  using ctl::formula::formula_dag;
+  ctl::checker::sat_calc calc(opts.threads);
+  calc.eg = opts.eg;
+  ctl::checker::profiler prof;
+  const bool profiling = opts.stats != nullptr || opts.trace != nullptr;
+  if(profiling) calc.prof = &prof;
+  if(opts.fair) calc.make_fair(ts);
+
+  // the symbolic backend encodes the loaded TS as BDDs once, up front
+  ctl::bdd::manager mgr;
+  std::optional<ctl::graph::symbolic_ts> sym;
+  ctl::checker::symbolic_sat_calc sym_calc;
+  if(opts.symbolic) {
+    auto encode_start = clk::now();
+    sym.emplace(ctl::graph::symbolic_ts::from_explicit(mgr, ts));
+    load_time += ms_since(encode_start);
+  }
+
+  if(opts.batch) {
+    std::cout << "Loaded " << orig.size() << " states in " << std::fixed << std::setprecision(3) << load_time << " ms\n";
+    if(opts.local) {
+      return run_batch(strm, formula_file, [&](const formula_dag &dag, const std::vector<formula_dag::id> &roots, auto &&report) {
+        ctl::checker::local_checker local(ts, dag);
+        for(size_t k = 0; k < roots.size(); k++) report(k, local.models(roots[k]), std::nullopt);
+      });
+    }
+    if(opts.symbolic) {
+      return run_batch(strm, formula_file, [&](const formula_dag &dag, const std::vector<formula_dag::id> &roots, auto &&report) {
+        sym_calc.sat_all(dag, roots, *sym, [&](size_t k, const ctl::bdd::bdd &sat) {
+          const double count = red == nullptr ? sym->count(sat) : (double)red->lift(explicit_set(*sym, sat, ts.size())).count();
+          report(k, sym_calc.models(*sym, sat), count);
+        });
+      });
+    }
+    const int res = run_batch(strm, formula_file, [&](const formula_dag &dag, const std::vector<formula_dag::id> &roots, auto &&report) {
+      calc.sat_all(dag, roots, ts, [&](size_t k, const ctl::graph::state_set &sat) {
+        report(k, calc.models(ts, sat), (double)(red == nullptr ? sat.count() : red->lift(sat).count()));
+      });
+    });
+    return res == 0 && profiling ? write_profile(prof, opts) : res;
+  }
+
   ctl::formula::ctlf_node formula;
   try {
     formula = ctl::formula::parser::parse(strm);
@@ -40,19 +184,254 @@ int main(int argc, const char **argv) {
     return -3;
   }
 
-  ctl::checker::sat_calc calc;
-  ctl::graph::sparse_ts ts2 = ts;
+  if(opts.local) {
+    formula_dag dag;
+    const auto root = dag.intern(formula);
+    ctl::checker::local_checker local(ts, dag);
+    const bool verdict = local.models(root);
+    std::cout << "Checked locally: evaluated " << local.explored() << " (subformula, state) pairs\n";
+    if(verdict) std::cout << "M ⊨ phi\n";
+    else std::cout << "M ⊭ phi \n";
+    return 0;
+  }
 
-  auto sat = calc.sat(formula, ts2);
+  ctl::graph::state_set sat_states;
+  bool verdict;
+  if(opts.symbolic) {
+    auto sat = sym_calc.sat(formula, *sym);
+    sat_states = explicit_set(*sym, sat, ts.size());
+    verdict = sym_calc.models(*sym, sat);
+  }
+  else {
+    sat_states = calc.sat(formula, ts);
+    verdict = calc.models(ts, sat_states);
+  }
+  if(red != nullptr) sat_states = red->lift(sat_states);
 
   std::cout << "SAT(";
   formula.dump();
   std::cout << ") = {\n";
-  for(const auto &node: sat) {
-    std::cout << "  node(" << node->name() << ", { ... })\n";
+  for(const auto idx: sat_states) {
+    std::cout << "  node(" << orig.name(idx) << ", { ... })\n";
   }
   std::cout << "}\n";
 
-  if(calc.models(ts2, formula)) std::cout << "M ⊨ phi\n";
+  if(verdict) std::cout << "M ⊨ phi\n";
   else std::cout << "M ⊭ phi \n";
+  return profiling ? write_profile(prof, opts) : 0;
+}
+
+// Checks the formula(s) in formula_file against the binary TS file graph_file, streaming its edges from disk (--external).
+int check_external(const char *graph_file, const char *formula_file, const options &opts) {
+  auto load_start = clk::now();
+  std::optional<ctl::graph::external_ts> ts;
+  try {
+    ts.emplace(graph_file, opts.block_bytes);
+  }
+  catch(const std::exception &exc) {
+    std::cerr << "Error while loading: " << exc.what() << "\n";
+    return -3;
+  }
+  const double load_time = ms_since(load_start);
+
+  std::ifstream strm(formula_file);
+  if(!strm.good()) {
+    std::cerr << "Error: can't open file " << formula_file << " for reading.\n";
+    return -2;
+  }
+
+  using ctl::formula::formula_dag;
+  ctl::checker::external_checker calc(*ts);
+  auto report_io = [&]() {
+    std::cout << "Checked out of core: " << calc.sweeps() << " sweeps over " << ts->blocks().size() << " blocks, "
+              << std::fixed << std::setprecision(1) << (double)ts->bytes_read() / (1 << 20) << " MiB read\n";
+  };
+
+  try {
+    if(opts.batch) {
+      std::cout << "Loaded " << ts->size() << " states in " << std::fixed << std::setprecision(3) << load_time << " ms\n";
+      const int res = run_batch(strm, formula_file, [&](const formula_dag &dag, const std::vector<formula_dag::id> &roots, auto &&report) {
+        calc.sat_all(dag, roots, [&](size_t k, const ctl::graph::state_set &sat) {
+          report(k, calc.models(sat), (double)sat.count());
+        });
+      });
+      if(res == 0) report_io();
+      return res;
+    }
+
+    ctl::formula::ctlf_node formula;
+    try {
+      formula = ctl::formula::parser::parse(strm);
+    }
+    catch(const std::exception &exc) {
+      std::cerr << "Error while parsing: " << exc.what() << "\n";
+      return -3;
+    }
+
+    const auto sat_states = calc.sat(formula);
+    const bool verdict = calc.models(sat_states);
+    report_io();
+    std::cout << "SAT(";
+    formula.dump();
+    std::cout << ") = {\n";
+    ts->for_each_name(sat_states, [](size_t, std::string_view name) { std::cout << "  node(" << name << ", { ... })\n"; });
+    std::cout << "}\n";
+
+    if(verdict) std::cout << "M ⊨ phi\n";
+    else std::cout << "M ⊭ phi \n";
+  }
+  catch(const std::exception &exc) {
+    // the edges are read while checking, so I/O errors and corrupt blocks only show up here
+    std::cerr << "Error while checking: " << exc.what() << "\n";
+    return -3;
+  }
+  return 0;
+}
+
+// Everything after loading the TS; formula_file may be null when the TS only has to be converted.
+template <ctl::graph::TS_view TS>
+int run(const TS &ts, double load_time, const char *formula_file, const options &opts) {
+  if(opts.save_binary != nullptr) {
+    auto save_start = clk::now();
+    try {
+      ctl::graph::mapped_ts::save(ts, opts.save_binary);
+    }
+    catch(const std::exception &exc) {
+      std::cerr << "Error while saving: " << exc.what() << "\n";
+      return -2;
+    }
+    std::cout << "Saved " << ts.size() << " states to " << opts.save_binary << " in " << std::fixed
+              << std::setprecision(3) << ms_since(save_start) << " ms\n";
+  }
+  if(formula_file == nullptr) return 0;
+
+  // reductions are applied in order, each on the result of the previous one
+  std::optional<ctl::graph::reduction> red;
+  auto reduce_start = clk::now();
+  if(opts.prune_unreachable) {
+    red = ctl::graph::prune_unreachable(ts);
+    std::cout << "Pruned to " << red->kept() << " reachable states (of " << ts.size() << ")\n";
+  }
+  if(opts.bisim) {
+    auto pool = opts.threads > 1 ? std::make_unique<ctl::thread_pool>(opts.threads) : nullptr;
+    const size_t before = red ? red->ts.size() : ts.size();
+    if(red) red = ctl::graph::compose(*red, ctl::graph::bisimulation_quotient(red->ts, pool.get()));
+    else red = ctl::graph::bisimulation_quotient(ts, pool.get());
+    std::cout << "Reduced to " << red->ts.size() << " bisimulation classes (of " << before << " states)\n";
+  }
+  load_time += ms_since(reduce_start);
+
+  if(red) return check(red->ts, ts, &*red, load_time, formula_file, opts);
+  return check(ts, ts, nullptr, load_time, formula_file, opts);
+}
+
+int main(int argc, const char **argv) {
+  options opts;
+  std::vector<const char *> files;
+  for(int i = 1; i < argc; i++) {
+    std::string_view arg = argv[i];
+    if(arg == "--batch") opts.batch = true;
+    else if(arg == "--symbolic") opts.symbolic = true;
+    else if(arg == "--local") opts.local = true;
+    else if(arg == "--fair") opts.fair = true;
+    else if(arg == "--prune-unreachable") opts.prune_unreachable = true;
+    else if(arg == "--bisim") opts.bisim = true;
+    else if(arg == "--external") opts.external = true;
+    else if(arg == "--verify") opts.verify = true;
+    else if(arg == "--block-size" && i + 1 < argc) {
+      std::string_view value = argv[++i];
+      size_t mib = 0;
+      const auto [end, err] = std::from_chars(value.data(), value.data() + value.size(), mib);
+      if(err != std::errc{} || end != value.data() + value.size() || mib > (SIZE_MAX >> 20)) {
+        std::cerr << "Error: invalid block size `" << value << "' (expected a number of MiB, at most " << (SIZE_MAX >> 20) << ").\n";
+        return -1;
+      }
+      opts.block_bytes = std::max<size_t>(1, mib) << 20;
+    }
+    else if(arg == "--threads" && i + 1 < argc) {
+      opts.threads = std::strtoul(argv[++i], nullptr, 10);
+      if(opts.threads == 0) opts.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    else if(arg == "--eg" && i + 1 < argc) {
+      std::string_view engine = argv[++i];
+      if(engine == "scc") opts.eg = ctl::checker::sat_calc::eg_engine::SCC;
+      else if(engine == "counting") opts.eg = ctl::checker::sat_calc::eg_engine::COUNTING;
+      else {
+        std::cerr << "Error: unknown EG engine `" << engine << "' (expected `counting' or `scc').\n";
+        return -1;
+      }
+    }
+    else if(arg == "--save-binary" && i + 1 < argc) opts.save_binary = argv[++i];
+    else if(arg == "--stats" && i + 1 < argc) opts.stats = argv[++i];
+    else if(arg == "--trace" && i + 1 < argc) opts.trace = argv[++i];
+    else files.push_back(argv[i]);
+  }
+
+  if(files.size() != 2 && !(files.size() == 1 && opts.save_binary != nullptr)) {
+    std::cerr << "Usage: " << argv[0] << " [options] <input graph file> <input formula file>\n"
+              << "       " << argv[0] << " [options] --batch <input graph file> <input file with one formula per line>\n"
+              << "       " << argv[0] << " --save-binary <output file> <input graph file>\n"
+              << "Options: --threads <n>, --eg <counting|scc>, --symbolic, --local, --fair, --save-binary <output file>,\n"
+              << "         --prune-unreachable, --bisim, --external, --block-size <MiB>, --verify, --stats <json file>,\n"
+              << "         --trace <json file>\n";
+    return -1;
+  }
+  if(opts.local && opts.symbolic) {
+    std::cerr << "Error: --local and --symbolic can't be combined.\n";
+    return -1;
+  }
+  if(opts.fair && (opts.local || opts.symbolic)) {
+    std::cerr << "Error: --fair is only supported by the explicit-state checker; it can't be combined with --local or --symbolic.\n";
+    return -1;
+  }
+  if((opts.stats != nullptr || opts.trace != nullptr) && (opts.local || opts.symbolic)) {
+    std::cerr << "Error: --stats and --trace profile the explicit-state checker; they can't be combined with --local or --symbolic.\n";
+    return -1;
+  }
+
+  if(opts.external && (opts.symbolic || opts.local || opts.fair || opts.prune_unreachable || opts.bisim ||
+                       opts.save_binary != nullptr || opts.stats != nullptr || opts.trace != nullptr)) {
+    std::cerr << "Error: --external can't be combined with --symbolic, --local, --fair, --prune-unreachable, --bisim, "
+                 "--save-binary, --stats or --trace.\n";
+    return -1;
+  }
+
+  if(!std::ifstream(files[0]).good()) {
+    std::cerr << "Error: can't open file " << files[0] << " for reading.\n";
+    return -2;
+  }
+  const char *formula_file = files.size() == 2 ? files[1] : nullptr;
+
+  if(opts.external) {
+    if(!ctl::graph::mapped_ts::is_binary(files[0])) {
+      std::cerr << "Error: --external needs a binary TS file (convert it with --save-binary first).\n";
+      return -1;
+    }
+    return check_external(files[0], formula_file, opts);
+  }
+
+  // binary TS files are mapped and used in place; anything else is parsed as a .gts file
+  auto load_start = clk::now();
+  if(ctl::graph::mapped_ts::is_binary(files[0])) {
+    std::optional<ctl::graph::mapped_ts> ts;
+    try {
+      ts.emplace(files[0]);
+      if(opts.verify) ts->verify();
+    }
+    catch(const std::exception &exc) {
+      std::cerr << "Error while loading: " << exc.what() << "\n";
+      return -3;
+    }
+    return run(*ts, ms_since(load_start), formula_file, opts);
+  }
+
+  ctl::graph::default_ts ts;
+  try {
+    ts = ctl::graph::graph_reader::parse_file(files[0], opts.threads);
+  }
+  catch(const std::exception &exc) {
+    std::cerr << "Error while parsing: " << exc.what() << "\n";
+    return -3;
+  }
+  return run(ts, ms_since(load_start), formula_file, opts);
 }
@@ -0,0 +1,377 @@
+//
+// Created by jay on 7/25/23.
+//
+
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include "bdd/bdd.hpp"
+
+using namespace ctl::bdd;
+
+namespace {
+inline size_t hash3(std::uint32_t a, std::uint32_t b, std::uint32_t c) {
+  std::uint64_t h = a * 0x9E3779B97F4A7C15ull;
+  h ^= (b + 0x7F4A7C15ull) * 0xC2B2AE3D27D4EB4Full;
+  h ^= (c + 0x165667B1ull) * 0x165667B19E3779F9ull;
+  return (size_t)(h ^ (h >> 29));
+}
+}
+
+bdd::bdd(manager *mgr, ref_t root) : mgr{mgr}, root{root} {
+  if(mgr != nullptr) mgr->ref(root);
+}
+
+bdd::bdd(const bdd &other) : bdd(other.mgr, other.root) {}
+
+bdd::bdd(bdd &&other) noexcept : mgr{other.mgr}, root{other.root} {
+  other.mgr = nullptr;
+  other.root = 0;
+}
+
+bdd &bdd::operator=(const bdd &other) {
+  if(other.mgr != nullptr) other.mgr->ref(other.root);
+  if(mgr != nullptr) mgr->deref(root);
+  mgr = other.mgr;
+  root = other.root;
+  return *this;
+}
+
+bdd &bdd::operator=(bdd &&other) noexcept {
+  if(this == &other) return *this;
+  if(mgr != nullptr) mgr->deref(root);
+  mgr = other.mgr;
+  root = other.root;
+  other.mgr = nullptr;
+  other.root = 0;
+  return *this;
+}
+
+bdd::~bdd() {
+  if(mgr != nullptr) mgr->deref(root);
+}
+
+bdd bdd::operator&(const bdd &other) const { return mgr->apply_and(*this, other); }
+bdd bdd::operator|(const bdd &other) const { return mgr->apply_or(*this, other); }
+bdd bdd::operator^(const bdd &other) const { return mgr->apply_xor(*this, other); }
+bdd bdd::operator!() const { return mgr->negate(*this); }
+bdd &bdd::operator&=(const bdd &other) { return *this = *this & other; }
+bdd &bdd::operator|=(const bdd &other) { return *this = *this | other; }
+
+manager::manager(size_t cache_bits) : gc_threshold{1u << 16}, cache(size_t{1} << cache_bits) {
+  nodes.reserve(gc_threshold);
+  nodes.push_back(node{ terminal, 0, 0, 0, nil }); // false
+  nodes.push_back(node{ terminal, 1, 1, 0, nil }); // true
+  buckets.assign(gc_threshold, nil);
+}
+
+var_t manager::new_var() {
+  return (var_t)vars++;
+}
+
+bdd manager::zero() { return { this, 0 }; }
+bdd manager::one() { return { this, 1 }; }
+
+bdd manager::var(var_t v) {
+  maybe_gc();
+  return { this, mk(v, 0, 1) };
+}
+
+bdd manager::nvar(var_t v) {
+  maybe_gc();
+  return { this, mk(v, 1, 0) };
+}
+
+bdd manager::cube(const std::vector<var_t> &vs) {
+  maybe_gc();
+  std::vector<var_t> sorted = vs;
+  std::ranges::sort(sorted, std::greater<>{});
+  ref_t res = 1;
+  for(const auto v: sorted) res = mk(v, 0, res);
+  return { this, res };
+}
+
+bdd manager::apply_and(const bdd &f, const bdd &g) {
+  maybe_gc();
+  return { this, and_rec(f.id(), g.id()) };
+}
+
+bdd manager::apply_or(const bdd &f, const bdd &g) {
+  maybe_gc();
+  return { this, or_rec(f.id(), g.id()) };
+}
+
+bdd manager::apply_xor(const bdd &f, const bdd &g) {
+  maybe_gc();
+  return { this, xor_rec(f.id(), g.id()) };
+}
+
+bdd manager::negate(const bdd &f) {
+  maybe_gc();
+  return { this, not_rec(f.id()) };
+}
+
+bdd manager::exists(const bdd &f, const bdd &cube) {
+  maybe_gc();
+  return { this, exists_rec(f.id(), cube.id()) };
+}
+
+bdd manager::and_exists(const bdd &f, const bdd &g, const bdd &cube) {
+  maybe_gc();
+  return { this, and_exists_rec(f.id(), g.id(), cube.id()) };
+}
+
+bdd manager::replace(const bdd &f, const std::vector<var_t> &map) {
+  maybe_gc();
+  std::unordered_map<ref_t, ref_t> memo;
+  auto rec = [&](auto &self, ref_t r) -> ref_t {
+    if(r <= 1) return r;
+    if(auto it = memo.find(r); it != memo.end()) return it->second;
+    const var_t v = level(r);
+    const ref_t lo = self(self, nodes[r].low);
+    const ref_t hi = self(self, nodes[r].high);
+    return memo[r] = mk(map[v], lo, hi);
+  };
+  return { this, rec(rec, f.id()) };
+}
+
+double manager::sat_count(const bdd &f, const std::vector<var_t> &vs) {
+  std::vector<var_t> sorted = vs;
+  std::ranges::sort(sorted);
+  auto pos = [&](ref_t r) -> size_t {
+    if(r <= 1) return sorted.size();
+    return (size_t)(std::ranges::lower_bound(sorted, level(r)) - sorted.begin());
+  };
+
+  std::unordered_map<ref_t, double> memo;
+  auto rec = [&](auto &self, ref_t r) -> double {
+    if(r <= 1) return (double)r;
+    if(auto it = memo.find(r); it != memo.end()) return it->second;
+    const size_t p = pos(r);
+    const ref_t lo = nodes[r].low, hi = nodes[r].high;
+    const double res = self(self, lo) * std::ldexp(1.0, (int)(pos(lo) - p - 1)) +
+                       self(self, hi) * std::ldexp(1.0, (int)(pos(hi) - p - 1));
+    return memo[r] = res;
+  };
+  return rec(rec, f.id()) * std::ldexp(1.0, (int)pos(f.id()));
+}
+
+bool manager::eval(const bdd &f, const std::vector<bool> &assignment) const {
+  ref_t r = f.id();
+  while(r > 1) r = assignment[level(r)] ? nodes[r].high : nodes[r].low;
+  return r == 1;
+}
+
+size_t manager::live_nodes() const {
+  return nodes.size() - free_count;
+}
+
+ref_t manager::mk(var_t v, ref_t low, ref_t high) {
+  if(low == high) return low;
+
+  const size_t mask = buckets.size() - 1;
+  const size_t b = hash3(v, low, high) & mask;
+  for(ref_t r = buckets[b]; r != nil; r = nodes[r].next) {
+    const auto &n = nodes[r];
+    if(n.var == v && n.low == low && n.high == high) return r;
+  }
+
+  ref_t r;
+  if(free_list != nil) {
+    r = free_list;
+    free_list = nodes[r].next;
+    free_count--;
+    nodes[r] = node{ v, low, high, 0, buckets[b] };
+  }
+  else {
+    r = (ref_t)nodes.size();
+    nodes.push_back(node{ v, low, high, 0, buckets[b] });
+  }
+  buckets[b] = r;
+
+  if(nodes.size() > buckets.size()) rehash();
+  return r;
+}
+
+void manager::rehash() {
+  buckets.assign(buckets.size() * 2, nil);
+  const size_t mask = buckets.size() - 1;
+  for(ref_t r = 2; r < nodes.size(); r++) {
+    auto &n = nodes[r];
+    if(n.var == terminal) continue; // free slot
+    const size_t b = hash3(n.var, n.low, n.high) & mask;
+    n.next = buckets[b];
+    buckets[b] = r;
+  }
+}
+
+bool manager::cache_find(op o, ref_t a, ref_t b, ref_t c, ref_t &res) const {
+  const auto &e = cache[hash3((std::uint32_t)o ^ (a << 3), b, c) & (cache.size() - 1)];
+  if(e.o != o || e.a != a || e.b != b || e.c != c) return false;
+  res = e.res;
+  return true;
+}
+
+void manager::cache_put(op o, ref_t a, ref_t b, ref_t c, ref_t res) {
+  cache[hash3((std::uint32_t)o ^ (a << 3), b, c) & (cache.size() - 1)] = entry{ o, a, b, c, res };
+}
+
+ref_t manager::and_rec(ref_t f, ref_t g) {
+  if(f == 0 || g == 0) return 0;
+  if(f == 1) return g;
+  if(g == 1 || f == g) return f;
+  if(f > g) std::swap(f, g);
+
+  ref_t res;
+  if(cache_find(op::AND, f, g, 0, res)) return res;
+  const var_t v = std::min(level(f), level(g));
+  const ref_t fl = level(f) == v ? nodes[f].low : f, fh = level(f) == v ? nodes[f].high : f;
+  const ref_t gl = level(g) == v ? nodes[g].low : g, gh = level(g) == v ? nodes[g].high : g;
+  const ref_t lo = and_rec(fl, gl);
+  const ref_t hi = and_rec(fh, gh);
+  res = mk(v, lo, hi);
+  cache_put(op::AND, f, g, 0, res);
+  return res;
+}
+
+ref_t manager::or_rec(ref_t f, ref_t g) {
+  if(f == 1 || g == 1) return 1;
+  if(f == 0) return g;
+  if(g == 0 || f == g) return f;
+  if(f > g) std::swap(f, g);
+
+  ref_t res;
+  if(cache_find(op::OR, f, g, 0, res)) return res;
+  const var_t v = std::min(level(f), level(g));
+  const ref_t fl = level(f) == v ? nodes[f].low : f, fh = level(f) == v ? nodes[f].high : f;
+  const ref_t gl = level(g) == v ? nodes[g].low : g, gh = level(g) == v ? nodes[g].high : g;
+  const ref_t lo = or_rec(fl, gl);
+  const ref_t hi = or_rec(fh, gh);
+  res = mk(v, lo, hi);
+  cache_put(op::OR, f, g, 0, res);
+  return res;
+}
+
+ref_t manager::xor_rec(ref_t f, ref_t g) {
+  if(f == g) return 0;
+  if(f == 0) return g;
+  if(g == 0) return f;
+  if(f == 1) return not_rec(g);
+  if(g == 1) return not_rec(f);
+  if(f > g) std::swap(f, g);
+
+  ref_t res;
+  if(cache_find(op::XOR, f, g, 0, res)) return res;
+  const var_t v = std::min(level(f), level(g));
+  const ref_t fl = level(f) == v ? nodes[f].low : f, fh = level(f) == v ? nodes[f].high : f;
+  const ref_t gl = level(g) == v ? nodes[g].low : g, gh = level(g) == v ? nodes[g].high : g;
+  const ref_t lo = xor_rec(fl, gl);
+  const ref_t hi = xor_rec(fh, gh);
+  res = mk(v, lo, hi);
+  cache_put(op::XOR, f, g, 0, res);
+  return res;
+}
+
+ref_t manager::not_rec(ref_t f) {
+  if(f <= 1) return 1 - f;
+
+  ref_t res;
+  if(cache_find(op::NOT, f, 0, 0, res)) return res;
+  const ref_t lo = not_rec(nodes[f].low);
+  const ref_t hi = not_rec(nodes[f].high);
+  res = mk(level(f), lo, hi);
+  cache_put(op::NOT, f, 0, 0, res);
+  return res;
+}
+
+ref_t manager::exists_rec(ref_t f, ref_t cube) {
+  if(f <= 1) return f;
+  while(cube > 1 && level(cube) < level(f)) cube = nodes[cube].high;
+  if(cube == 1) return f;
+
+  ref_t res;
+  if(cache_find(op::EXISTS, f, cube, 0, res)) return res;
+  const ref_t lo = exists_rec(nodes[f].low, cube);
+  if(level(cube) == level(f)) {
+    res = lo == 1 ? 1 : or_rec(lo, exists_rec(nodes[f].high, cube));
+  }
+  else {
+    res = mk(level(f), lo, exists_rec(nodes[f].high, cube));
+  }
+  cache_put(op::EXISTS, f, cube, 0, res);
+  return res;
+}
+
+ref_t manager::and_exists_rec(ref_t f, ref_t g, ref_t cube) {
+  if(f == 0 || g == 0) return 0;
+  if(f == 1 && g == 1) return 1;
+  if(cube == 1) return and_rec(f, g);
+  if(f == 1 || f == g) return exists_rec(g, cube);
+  if(g == 1) return exists_rec(f, cube);
+  if(f > g) std::swap(f, g);
+
+  const var_t v = std::min(level(f), level(g));
+  while(cube > 1 && level(cube) < v) cube = nodes[cube].high;
+  if(cube == 1) return and_rec(f, g);
+
+  ref_t res;
+  if(cache_find(op::AND_EXISTS, f, g, cube, res)) return res;
+  const ref_t fl = level(f) == v ? nodes[f].low : f, fh = level(f) == v ? nodes[f].high : f;
+  const ref_t gl = level(g) == v ? nodes[g].low : g, gh = level(g) == v ? nodes[g].high : g;
+  if(level(cube) == v) {
+    const ref_t next = nodes[cube].high;
+    const ref_t lo = and_exists_rec(fl, gl, next);
+    res = lo == 1 ? 1 : or_rec(lo, and_exists_rec(fh, gh, next));
+  }
+  else {
+    const ref_t lo = and_exists_rec(fl, gl, cube);
+    const ref_t hi = and_exists_rec(fh, gh, cube);
+    res = mk(v, lo, hi);
+  }
+  cache_put(op::AND_EXISTS, f, g, cube, res);
+  return res;
+}
+
+void manager::maybe_gc() {
+  if(free_list != nil || nodes.size() < gc_threshold) return;
+  gc();
+  // keep collecting only while it pays off; otherwise let the table grow
+  if(free_count < nodes.size() / 4) gc_threshold = nodes.size() * 2;
+}
+
+void manager::gc() {
+  std::vector<bool> marked(nodes.size(), false);
+  marked[0] = marked[1] = true;
+  std::vector<ref_t> stack;
+  for(ref_t r = 2; r < nodes.size(); r++) {
+    if(nodes[r].var != terminal && nodes[r].refs > 0) stack.push_back(r);
+  }
+  while(!stack.empty()) {
+    const ref_t r = stack.back();
+    stack.pop_back();
+    if(marked[r]) continue;
+    marked[r] = true;
+    stack.push_back(nodes[r].low);
+    stack.push_back(nodes[r].high);
+  }
+
+  free_list = nil;
+  free_count = 0;
+  for(ref_t r = (ref_t)nodes.size() - 1; r >= 2; r--) {
+    if(marked[r]) continue;
+    nodes[r] = node{ terminal, 0, 0, 0, free_list };
+    free_list = r;
+    free_count++;
+  }
+
+  std::ranges::fill(buckets, nil);
+  const size_t mask = buckets.size() - 1;
+  for(ref_t r = 2; r < nodes.size(); r++) {
+    auto &n = nodes[r];
+    if(n.var == terminal) continue;
+    const size_t b = hash3(n.var, n.low, n.high) & mask;
+    n.next = buckets[b];
+    buckets[b] = r;
+  }
+  std::ranges::fill(cache, entry{});
+}
@@ -0,0 +1,94 @@
+//
+// Created by jay on 8/7/23.
+//
+
+#include <utility>
+#include "checker/external.hpp"
+
+using namespace ctl;
+using namespace ctl::checker;
+
+external_checker::set_t external_checker::sat(const formula::ctlf_node &formula) {
+  formula::formula_dag dag;
+  const id root = dag.intern(formula);
+  set_t res;
+  sat_all(dag, { root }, [&res](size_t, const set_t &sat) { res = sat; });
+  return res;
+}
+
+bool external_checker::models(const set_t &sat) const {
+  return std::ranges::any_of(ts.initial(), [&sat](size_t s) { return sat.contains(s); });
+}
+
+external_checker::set_t external_checker::eval_node(const formula::formula_dag &dag, id i, const std::vector<set_t> &results) {
+  const auto &curr = dag[i];
+  auto child = [&results, &curr](size_t c) -> const set_t & { return results[curr.children[c]]; };
+  const size_t n = ts.size();
+  switch(curr.n) {
+    case formula::node_type::TRUE: return set_t(n, true);
+    case formula::node_type::ATOMIC: return sat_atom(curr.atom);
+    case formula::node_type::CONJUNCTION: return child(0) & child(1);
+    case formula::node_type::NEGATION: return ~child(0);
+    case formula::node_type::DISJUNCTION: return child(0) | child(1);
+    case formula::node_type::IMPLICATION: return (~child(0)) | child(1);
+    case formula::node_type::E_NEXT: return next(child(0), false);
+    case formula::node_type::A_NEXT: return next(child(0), true);
+    case formula::node_type::E_UNTIL: return least(child(0), child(1), false);
+    case formula::node_type::A_UNTIL: return least(child(0), child(1), true);
+    case formula::node_type::E_FUTURE: return least(set_t(n, true), child(0), false);
+    case formula::node_type::A_FUTURE: return least(set_t(n, true), child(0), true);
+    case formula::node_type::E_ALWAYS: return greatest(child(0), false);
+    case formula::node_type::A_ALWAYS: return greatest(child(0), true);
+  }
+  return {};
+}
+
+external_checker::set_t external_checker::sat_atom(const std::string &atom) const {
+  const graph::prop_id id = ts.propositions().find(atom);
+  if(id == graph::prop_table::npos) return set_t(ts.size());
+  return ts.label(id);
+}
+
+external_checker::set_t external_checker::next(const set_t &sub, bool all) {
+  set_t res(ts.size());
+  sweep_count++;
+  ts.sweep(set_t(ts.size(), true), false, [&](size_t s, std::span<const graph::state_id> succ) {
+    auto in = [&sub](size_t t) { return sub.contains(t); };
+    if(all ? std::ranges::all_of(succ, in) : std::ranges::any_of(succ, in)) res.insert(s);
+  });
+  return res;
+}
+
+external_checker::set_t external_checker::least(const set_t &pre, set_t post, bool all) {
+  set_t &res = post;
+  set_t todo = pre - res; // the states that may still be added
+  bool changed = true;
+  for(bool reverse = false; changed && !todo.empty(); reverse = !reverse) {
+    changed = false;
+    sweep_count++;
+    ts.sweep(todo, reverse, [&](size_t s, std::span<const graph::state_id> succ) {
+      auto in = [&res](size_t t) { return res.contains(t); };
+      if(!(all ? std::ranges::all_of(succ, in) : std::ranges::any_of(succ, in))) return;
+      res.insert(s);
+      todo.erase(s);
+      changed = true;
+    });
+  }
+  return res;
+}
+
+external_checker::set_t external_checker::greatest(set_t sub, bool all) {
+  set_t &res = sub;
+  bool changed = true;
+  for(bool reverse = false; changed && !res.empty(); reverse = !reverse) {
+    changed = false;
+    sweep_count++;
+    ts.sweep(res, reverse, [&](size_t s, std::span<const graph::state_id> succ) {
+      auto in = [&res](size_t t) { return res.contains(t); };
+      if(all ? std::ranges::all_of(succ, in) : std::ranges::any_of(succ, in)) return;
+      res.erase(s);
+      changed = true;
+    });
+  }
+  return res;
+}
@@ -0,0 +1,234 @@
+//
+// Created by jay on 7/29/23.
+//
+
+#include <algorithm>
+#include "checker/incremental.hpp"
+
+using namespace ctl;
+using namespace ctl::checker;
+
+incremental::incremental(graph::sparse_ts &ts) : ts{ts}, added(ts.size()), removed(ts.size()), counts(ts.size(), 0) {}
+
+incremental::id incremental::watch(const formula::ctlf_node &formula) {
+  update();
+  const id root = dag.intern(formula.to_enf());
+  for(id i = results.size(); i < dag.size(); i++) results.push_back(calc.sat_node(dag[i], results, ts));
+  return root;
+}
+
+bool incremental::models(id root) const {
+  return std::ranges::any_of(ts.initial(), [this, root](size_t s) { return results[root].contains(s); });
+}
+
+void incremental::add_transition(size_t start, size_t end) {
+  if(std::ranges::find(ts.successors(start), end) != ts.successors(start).end()) return;
+  ts.add_transition(start, end);
+  added.insert(start);
+  dirty = true;
+}
+
+void incremental::remove_transition(size_t start, size_t end) {
+  if(std::ranges::find(ts.successors(start), end) == ts.successors(start).end()) return;
+  ts.remove_transition(start, end);
+  removed.insert(start);
+  dirty = true;
+}
+
+void incremental::add_label(size_t state, const graph::prop &p) {
+  if(has_label(state, p)) return;
+  ts.add_label(state, p);
+  toggle_label(state, p);
+}
+
+void incremental::remove_label(size_t state, const graph::prop &p) {
+  if(!has_label(state, p)) return;
+  ts.remove_label(state, p);
+  toggle_label(state, p);
+}
+
+bool incremental::has_label(size_t state, const graph::prop &p) const {
+  const auto id = ts.propositions().find(p);
+  return id != graph::prop_table::npos && state < ts.label(id).size() && ts.label(id).contains(state);
+}
+
+void incremental::toggle_label(size_t state, const graph::prop &p) {
+  auto [it, _] = relabelled.try_emplace(p, ts.size());
+  if(it->second.contains(state)) it->second.erase(state);
+  else it->second.insert(state);
+  dirty = true;
+}
+
+void incremental::update() {
+  if(!dirty) return;
+
+  // changed[i]: the states on which node i's result actually flipped
+  std::vector<set_t> changed(results.size());
+  for(id i = 0; i < results.size(); i++) changed[i] = update_node(i, changed);
+
+  added.clear();
+  removed.clear();
+  relabelled.clear();
+  dirty = false;
+}
+
+incremental::set_t incremental::update_node(id i, const std::vector<set_t> &changed) {
+  const auto &curr = dag[i];
+  const size_t n = ts.size();
+  auto &res = results[i];
+  auto child = [&](size_t c) -> const set_t & { return results[curr.children[c]]; };
+  auto child_changed = [&](size_t c) -> const set_t & { return changed[curr.children[c]]; };
+
+  switch(curr.n) {
+    case formula::node_type::TRUE:
+      return set_t(n);
+    case formula::node_type::ATOMIC: {
+      auto it = relabelled.find(curr.atom);
+      if(it == relabelled.end()) return set_t(n);
+      for(const auto s: it->second) {
+        if(res.contains(s)) res.erase(s);
+        else res.insert(s);
+      }
+      return it->second;
+    }
+    case formula::node_type::NEGATION: {
+      for(const auto s: child_changed(0)) {
+        if(res.contains(s)) res.erase(s);
+        else res.insert(s);
+      }
+      return child_changed(0);
+    }
+    case formula::node_type::CONJUNCTION: {
+      set_t diff(n);
+      for(const auto s: child_changed(0) | child_changed(1)) {
+        const bool now = child(0).contains(s) && child(1).contains(s);
+        if(now == res.contains(s)) continue;
+        diff.insert(s);
+        if(now) res.insert(s);
+        else res.erase(s);
+      }
+      return diff;
+    }
+    case formula::node_type::E_NEXT: {
+      set_t candidates = added | removed;
+      for(const auto s: child_changed(0)) {
+        for(const auto p: ts.predecessors(s)) candidates.insert(p);
+      }
+      set_t diff(n);
+      for(const auto s: candidates) {
+        const bool now = std::ranges::any_of(ts.successors(s), [&](size_t t) { return child(0).contains(t); });
+        if(now == res.contains(s)) continue;
+        diff.insert(s);
+        if(now) res.insert(s);
+        else res.erase(s);
+      }
+      return diff;
+    }
+    case formula::node_type::E_UNTIL:
+      return update_e_until(i, child(0), child(1), child_changed(0), child_changed(1));
+    case formula::node_type::E_ALWAYS:
+      return update_e_always(i, child(0), child_changed(0));
+    default: // never in the DAG, see watch()
+      break;
+  }
+  return set_t(n);
+}
+
+incremental::set_t incremental::backward_closure(const set_t &seeds, const set_t &through) const {
+  set_t res = seeds;
+  std::vector<graph::state_id> stack{seeds.begin(), seeds.end()};
+  while(!stack.empty()) {
+    const size_t v = stack.back();
+    stack.pop_back();
+    for(const auto p: ts.predecessors(v)) {
+      if(!res.contains(p) && through.contains(p)) {
+        res.insert(p);
+        stack.push_back(p);
+      }
+    }
+  }
+  return res;
+}
+
+incremental::set_t incremental::update_e_until(id i, const set_t &pre, const set_t &post, const set_t &pre_changed,
+                                               const set_t &post_changed) {
+  auto &res = results[i];
+  const set_t old = res;
+
+  // over-delete: every state that reaches something lost through the old result may have depended on it
+  const set_t lost = ((pre_changed - pre) | (post_changed - post) | removed) & res;
+  res -= backward_closure(lost, res);
+
+  // re-derive: besides the over-deleted states, only states that gained something can start a new witness; the
+  // backward search then continues from every state that becomes true
+  std::vector<graph::state_id> frontier;
+  for(const auto s: (old - res) | (pre_changed & pre) | (post_changed & post) | added) {
+    if(res.contains(s)) continue;
+    const bool holds = post.contains(s) || (pre.contains(s) && std::ranges::any_of(ts.successors(s), [&res](size_t t) {
+      return res.contains(t);
+    }));
+    if(!holds) continue;
+    res.insert(s);
+    frontier.push_back(s);
+  }
+  while(!frontier.empty()) {
+    const size_t v = frontier.back();
+    frontier.pop_back();
+    for(const auto p: ts.predecessors(v)) {
+      if(pre.contains(p) && !res.contains(p)) {
+        res.insert(p);
+        frontier.push_back(p);
+      }
+    }
+  }
+
+  return (old - res) | (res - old);
+}
+
+incremental::set_t incremental::update_e_always(id i, const set_t &sub, const set_t &sub_changed) {
+  auto &res = results[i];
+  const set_t old = res;
+
+  // losses: prune states that left sub or lost their last successor in the result, and propagate backwards
+  std::vector<graph::state_id> pruned;
+  auto prune = [&](size_t s) {
+    if(!res.contains(s)) return;
+    if(sub.contains(s) && std::ranges::any_of(ts.successors(s), [&res](size_t t) { return res.contains(t); })) return;
+    res.erase(s);
+    pruned.push_back(s);
+  };
+  for(const auto s: ((sub_changed - sub) | removed) & res) prune(s);
+  while(!pruned.empty()) {
+    const size_t v = pruned.back();
+    pruned.pop_back();
+    for(const auto p: ts.predecessors(v)) prune(p);
+  }
+
+  // gains: a new path can only start in a state that reaches (through sub) a gained state or transition; on those
+  // states, compute the greatest fixpoint with the current result as a fixed boundary
+  const set_t open = sub - res;
+  const set_t region = backward_closure(((sub_changed & sub) | added) & open, open);
+  std::vector<graph::state_id> dead;
+  for(const auto v: region) {
+    counts[v] = 0;
+    for(const auto t: ts.successors(v)) {
+      if(region.contains(t) || res.contains(t)) counts[v]++;
+    }
+    if(counts[v] == 0) dead.push_back(v);
+  }
+  set_t alive = region;
+  for(const auto v: dead) alive.erase(v);
+  while(!dead.empty()) {
+    const size_t v = dead.back();
+    dead.pop_back();
+    for(const auto p: ts.predecessors(v)) {
+      if(alive.contains(p) && --counts[p] == 0) {
+        alive.erase(p);
+        dead.push_back(p);
+      }
+    }
+  }
+  res |= alive;
+
+  return (old - res) | (res - old);
+}
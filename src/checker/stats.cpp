@@ -0,0 +1,151 @@
+//
+// Created by jay on 8/2/23.
+//
+
+#include <iomanip>
+#include <string_view>
+#include "checker/stats.hpp"
+
+using namespace ctl;
+using namespace ctl::checker;
+
+namespace {
+std::string json_string(const std::string &s) {
+  std::string res = "\"";
+  for(const char c: s) {
+    if(c == '"' || c == '\\') res += '\\';
+    res += c;
+  }
+  return res + "\"";
+}
+}
+
+double profiler::now_us() const {
+  return std::chrono::duration<double, std::micro>(clk::now() - origin).count();
+}
+
+size_t profiler::bytes(const graph::state_set &s) {
+  return s.words().size() * sizeof(graph::state_set::word);
+}
+
+void profiler::add(const formula::formula_dag &dag, formula::formula_dag::id node, clk::time_point start,
+                   const graph::state_set &result, op_counters &&counters) {
+  const double end_us = now_us();
+  const double start_us = std::chrono::duration<double, std::micro>(start - origin).count();
+  const size_t size = bytes(result);
+  const size_t now_live = live.fetch_add(size) + size;
+  size_t prev = peak.load();
+  while(now_live > prev && !peak.compare_exchange_weak(prev, now_live)) {}
+
+  std::lock_guard guard(m);
+  const auto [it, _] = threads.try_emplace(std::this_thread::get_id(), threads.size());
+  if(text.size() <= node) text.resize(node + 1);
+  text[node] = describe(dag, node);
+  recs.push_back({ node, dag[node].n, dag[node].children, text[node], it->second, start_us, end_us - start_us,
+                   result.count(), size, now_live, std::move(counters) });
+}
+
+void profiler::release(const graph::state_set &result) {
+  live.fetch_sub(bytes(result));
+}
+
+const char *profiler::op_name(formula::node_type n) {
+  switch(n) {
+    case formula::node_type::TRUE: return "true";
+    case formula::node_type::ATOMIC: return "atom";
+    case formula::node_type::CONJUNCTION: return "and";
+    case formula::node_type::NEGATION: return "not";
+    case formula::node_type::E_NEXT: return "EX";
+    case formula::node_type::E_UNTIL: return "EU";
+    case formula::node_type::E_ALWAYS: return "EG";
+    case formula::node_type::DISJUNCTION: return "or";
+    case formula::node_type::IMPLICATION: return "implies";
+    case formula::node_type::E_FUTURE: return "EF";
+    case formula::node_type::A_NEXT: return "AX";
+    case formula::node_type::A_UNTIL: return "AU";
+    case formula::node_type::A_ALWAYS: return "AG";
+    case formula::node_type::A_FUTURE: return "AF";
+  }
+  return "?";
+}
+
+std::string profiler::describe(const formula::formula_dag &dag, formula::formula_dag::id node) const {
+  constexpr size_t max_length = 120;
+  const auto &curr = dag[node];
+  auto child = [this, &curr](size_t c) {
+    const auto id = curr.children[c];
+    if(id < text.size() && !text[id].empty() && text[id].size() <= max_length) return text[id];
+    std::string ref = "#";
+    ref += std::to_string(id);
+    return ref;
+  };
+  // prefix (child 0) for unary operators, prefix (child 0) infix (child 1) for binary ones
+  auto wrap = [&child](std::string_view prefix, std::string_view infix = {}) {
+    std::string res(prefix);
+    res += "(";
+    res += child(0);
+    res += ")";
+    if(infix.empty()) return res;
+    res += infix;
+    res += "(";
+    res += child(1);
+    res += ")";
+    return res;
+  };
+  switch(curr.n) {
+    case formula::node_type::TRUE: return "true";
+    case formula::node_type::ATOMIC: return curr.atom;
+    case formula::node_type::CONJUNCTION: return wrap("", " /\\ ");
+    case formula::node_type::NEGATION: return wrap("!");
+    case formula::node_type::E_NEXT: return wrap("\\E \\X ");
+    case formula::node_type::E_UNTIL: return wrap("\\E ", " \\U ");
+    case formula::node_type::E_ALWAYS: return wrap("\\E \\G ");
+    case formula::node_type::DISJUNCTION: return wrap("", " \\/ ");
+    case formula::node_type::IMPLICATION: return wrap("", " -> ");
+    case formula::node_type::E_FUTURE: return wrap("\\E \\F ");
+    case formula::node_type::A_NEXT: return wrap("\\A \\X ");
+    case formula::node_type::A_UNTIL: return wrap("\\A ", " \\U ");
+    case formula::node_type::A_ALWAYS: return wrap("\\A \\G ");
+    case formula::node_type::A_FUTURE: return wrap("\\A \\F ");
+  }
+  return "?";
+}
+
+void profiler::write_json(std::ostream &out) const {
+  std::lock_guard guard(m);
+  double total_us = 0;
+  for(const auto &r: recs) total_us += r.duration_us;
+
+  out << std::fixed << std::setprecision(3) << "{\n  \"subformulas\": " << recs.size() << ",\n  \"total_ms\": "
+      << total_us / 1000 << ",\n  \"peak_result_bytes\": " << peak.load() << ",\n  \"nodes\": [\n";
+  for(size_t k = 0; k < recs.size(); k++) {
+    const auto &r = recs[k];
+    out << "    { \"node\": " << r.node << ", \"op\": \"" << op_name(r.op) << "\", \"formula\": "
+        << json_string(r.formula) << ", \"children\": [";
+    for(size_t c = 0; c < r.children.size(); c++) out << (c == 0 ? "" : ", ") << r.children[c];
+    out << "], \"thread\": " << r.thread << ", \"start_ms\": " << r.start_us / 1000 << ", \"time_ms\": "
+        << r.duration_us / 1000 << ", \"iterations\": " << r.counters.iterations << ", \"frontiers\": [";
+    for(size_t i = 0; i < r.counters.frontiers.size(); i++) out << (i == 0 ? "" : ", ") << r.counters.frontiers[i];
+    out << "], \"pre_calls\": " << r.counters.pre_calls << ", \"post_calls\": " << r.counters.post_calls
+        << ", \"edges\": " << r.counters.edges << ", \"result_states\": " << r.result_states << ", \"result_bytes\": "
+        << r.result_bytes << ", \"live_bytes\": " << r.live_bytes << " }" << (k + 1 == recs.size() ? "" : ",") << "\n";
+  }
+  out << "  ]\n}\n";
+}
+
+void profiler::write_trace(std::ostream &out) const {
+  std::lock_guard guard(m);
+  out << std::fixed << std::setprecision(3) << "{\"traceEvents\": [\n";
+  for(size_t k = 0; k < recs.size(); k++) {
+    const auto &r = recs[k];
+    out << "  {\"name\": " << json_string(std::string(op_name(r.op)) + " #" + std::to_string(r.node))
+        << ", \"cat\": \"sat\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << r.thread << ", \"ts\": " << r.start_us
+        << ", \"dur\": " << r.duration_us << ", \"args\": {\"formula\": " << json_string(r.formula)
+        << ", \"iterations\": " << r.counters.iterations << ", \"edges\": " << r.counters.edges
+        << ", \"result_states\": " << r.result_states << "}},\n";
+    // live result memory as a counter track
+    out << "  {\"name\": \"live result bytes\", \"ph\": \"C\", \"pid\": 1, \"ts\": " << r.start_us + r.duration_us
+        << ", \"args\": {\"bytes\": " << r.live_bytes << "}}" << (k + 1 == recs.size() ? "" : ",") << "\n";
+  }
+  out << "], \"displayTimeUnit\": \"ms\"}\n";
+}
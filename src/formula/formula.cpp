@@ -2,15 +2,12 @@
 // Created by jay on 6/30/23.
 //
 
-#include <random>
 #include <iostream>
 
 #include "formula/formula.hpp"
 
 using namespace ctl::formula;
 
-size_t ctlf_node::counter = std::random_device{}();
-
 std::ostream &operator<<(std::ostream &strm, const node_type &nt) {
   switch(nt) {
     case node_type::TRUE: return strm << "true";
@@ -20,35 +17,17 @@ std::ostream &operator<<(std::ostream &strm, const node_type &nt) {
     case node_type::E_NEXT: return strm << "next (\\E \\X)";
     case node_type::E_UNTIL: return strm << "until (\\E \\U)";
     case node_type::E_ALWAYS: return strm << "always (\\E \\G)";
+    case node_type::DISJUNCTION: return strm << "disjunction (\\/)";
+    case node_type::IMPLICATION: return strm << "implication (->)";
+    case node_type::E_FUTURE: return strm << "future (\\E \\F)";
+    case node_type::A_NEXT: return strm << "next (\\A \\X)";
+    case node_type::A_UNTIL: return strm << "until (\\A \\U)";
+    case node_type::A_ALWAYS: return strm << "always (\\A \\G)";
+    case node_type::A_FUTURE: return strm << "future (\\A \\F)";
   }
   return strm;
 }
 
-std::string ctlf_node::generate_var() const {
-  std::string res;
-
-  switch(n) {
-    case node_type::TRUE: res = "true"; break;
-    case node_type::ATOMIC: res = atom; break;
-    case node_type::CONJUNCTION: res = children[0].atom + " /\\ " + children[1].atom; break;
-    case node_type::NEGATION: res = "! " + children[0].atom; break;
-    case node_type::E_NEXT: res = "\\E NEXT " + children[0].atom; break;
-    case node_type::E_UNTIL: res = "\\E " + children[0].atom + " U " + children[1].atom; break;
-    case node_type::E_ALWAYS: res = "\\E ALWAYS " + children[0].atom; break;
-  }
-
-  res += " (" + std::to_string(counter) + ")";
-  counter++;
-
-  return res;
-}
-
-void ctlf_node::replace_subtree_by(const std::string &replacement) {
-  n = node_type::ATOMIC;
-  atom = replacement;
-  children.clear();
-}
-
 void ctlf_node::dump() const {
   switch(n) {
     case node_type::TRUE: std::cout << "true"; break;
@@ -82,7 +61,69 @@ void ctlf_node::dump() const {
       children[0].dump();
       std::cout << ")";
       break;
+    case node_type::DISJUNCTION:
+    case node_type::IMPLICATION:
+      std::cout << "(";
+      children[0].dump();
+      std::cout << (n == node_type::DISJUNCTION ? ") \\/ (" : ") -> (");
+      children[1].dump();
+      std::cout << ")";
+      break;
+    case node_type::A_UNTIL:
+      std::cout << "\\A (";
+      children[0].dump();
+      std::cout << ") \\U (";
+      children[1].dump();
+      std::cout << ")";
+      break;
+    case node_type::E_FUTURE:
+    case node_type::A_NEXT:
+    case node_type::A_ALWAYS:
+    case node_type::A_FUTURE:
+      std::cout << (n == node_type::E_FUTURE ? "\\E \\F (" : n == node_type::A_NEXT ? "\\A \\X (" :
+                    n == node_type::A_ALWAYS ? "\\A \\G (" : "\\A \\F (");
+      children[0].dump();
+      std::cout << ")";
+      break;
+  }
+}
+
+ctlf_node ctlf_node::to_enf() const {
+  auto make = [](node_type t, std::vector<ctlf_node> args) {
+    return ctlf_node{ .n = t, .atom = "", .children = std::move(args) };
+  };
+  auto neg = [&make](ctlf_node f) { return make(node_type::NEGATION, { std::move(f) }); };
+  auto conj = [&make](ctlf_node a, ctlf_node b) { return make(node_type::CONJUNCTION, { std::move(a), std::move(b) }); };
+  const ctlf_node t{ .n = node_type::TRUE, .atom = "true", .children = {} };
+
+  std::vector<ctlf_node> c;
+  for(const auto &child: children) c.push_back(child.to_enf());
+  switch(n) {
+    case node_type::TRUE:
+    case node_type::ATOMIC:
+    case node_type::CONJUNCTION:
+    case node_type::NEGATION:
+    case node_type::E_NEXT:
+    case node_type::E_UNTIL:
+    case node_type::E_ALWAYS:
+      return { .n = n, .atom = atom, .children = std::move(c) };
+    case node_type::DISJUNCTION: // a \/ b = !(!a /\ !b)
+      return neg(conj(neg(c[0]), neg(c[1])));
+    case node_type::IMPLICATION: // a -> b = !(a /\ !b)
+      return neg(conj(c[0], neg(c[1])));
+    case node_type::E_FUTURE: // EF a = E[true U a]
+      return make(node_type::E_UNTIL, { t, c[0] });
+    case node_type::A_NEXT: // AX a = !EX !a
+      return neg(make(node_type::E_NEXT, { neg(c[0]) }));
+    case node_type::A_ALWAYS: // AG a = !E[true U !a]
+      return neg(make(node_type::E_UNTIL, { t, neg(c[0]) }));
+    case node_type::A_FUTURE: // AF a = !EG !a
+      return neg(make(node_type::E_ALWAYS, { neg(c[0]) }));
+    case node_type::A_UNTIL: // A[a U b] = !E[!b U (!a /\ !b)] /\ !EG !b
+      return conj(neg(make(node_type::E_UNTIL, { neg(c[1]), conj(neg(c[0]), neg(c[1])) })),
+                  neg(make(node_type::E_ALWAYS, { neg(c[1]) })));
   }
+  return *this;
 }
 
 void ctlf_node::dump_tree(size_t d) const {
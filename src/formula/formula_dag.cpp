@@ -0,0 +1,56 @@
+//
+// Created by jay on 7/14/23.
+//
+
+#include <stack>
+#include <algorithm>
+#include "formula/formula_dag.hpp"
+
+using namespace ctl::formula;
+
+size_t formula_dag::node_hash::operator()(const node &n) const {
+  size_t h = std::hash<std::string>{}(n.atom) ^ ((size_t)n.n * 0x9e3779b97f4a7c15ULL);
+  for(const auto c: n.children) {
+    h ^= std::hash<size_t>{}(c) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+  }
+  return h;
+}
+
+formula_dag::id formula_dag::make(node_type n, std::string atom, std::vector<id> children) {
+  if(n == node_type::TRUE) atom = "true";
+  if(n == node_type::CONJUNCTION || n == node_type::DISJUNCTION) std::sort(children.begin(), children.end());
+
+  node key{ .n = n, .atom = std::move(atom), .children = std::move(children) };
+  auto it = lookup.find(key);
+  if(it != lookup.end()) return it->second;
+
+  nodes.push_back(key);
+  lookup.emplace(std::move(key), nodes.size() - 1);
+  return nodes.size() - 1;
+}
+
+formula_dag::id formula_dag::intern(const ctlf_node &formula) {
+  std::unordered_map<const ctlf_node *, id> done;
+  std::stack<const ctlf_node *> backtrack;
+  backtrack.push(&formula);
+
+  while(!backtrack.empty()) {
+    const ctlf_node *curr = backtrack.top();
+    bool can_intern = true;
+    for(const auto &c: curr->children) {
+      if(!done.contains(&c)) {
+        can_intern = false;
+        backtrack.push(&c);
+      }
+    }
+
+    if(can_intern) {
+      std::vector<id> children;
+      for(const auto &c: curr->children) children.push_back(done.at(&c));
+      done[curr] = make(curr->n, curr->atom, std::move(children));
+      backtrack.pop();
+    }
+  }
+
+  return done.at(&formula);
+}
@@ -13,7 +13,10 @@
 using namespace ctl;
 using namespace ctl::formula;
 
-#define TOKENS X(TRUE) X(ATOM) X(AND) X(NOT) X(EXISTS) X(NEXT) X(UNTIL) X(GLOBALLY) X(PAR_OPEN) X(PAR_CLOSE) X(IGNORE)
+// NEXT, GLOBALLY, FUTURE and UNTIL are the existential operators; lex() turns them into their A_ counterparts when
+// they belong to an \\A.
+#define TOKENS X(TRUE) X(ATOM) X(AND) X(OR) X(IMPLIES) X(NOT) X(EXISTS) X(ALL) X(NEXT) X(UNTIL) X(GLOBALLY) X(FUTURE) \
+               X(A_NEXT) X(A_UNTIL) X(A_GLOBALLY) X(A_FUTURE) X(PAR_OPEN) X(PAR_CLOSE) X(IGNORE)
 
 enum struct token_kind {
 #define X(t) t,
@@ -54,6 +57,7 @@ std::vector<token> lex(std::istream &strm) {
   std::vector<token> res;
   bool was_bsl = false;
   bool was_fsl = false;
+  bool was_dash = false;
   bool building = false;
   std::string curr;
 
@@ -63,9 +67,12 @@ std::vector<token> lex(std::istream &strm) {
     if(was_bsl) {
       switch(c) {
         case 'E': res.push_back({ token_kind::EXISTS, "" }); break;
+        case 'A': res.push_back({ token_kind::ALL, "" }); break;
         case 'X': res.push_back({ token_kind::NEXT, "" }); break;
         case 'G': res.push_back({ token_kind::GLOBALLY, "" }); break;
+        case 'F': res.push_back({ token_kind::FUTURE, "" }); break;
         case 'U': res.push_back({ token_kind::UNTIL, "" }); break;
+        case '/': res.push_back({ token_kind::OR, "" }); break;
         default: throw parse_error("Invalid token \\" + std::to_string(c) + ".");
       }
       was_bsl = false;
@@ -75,6 +82,11 @@ std::vector<token> lex(std::istream &strm) {
       else throw parse_error("Invalid token /" + std::string(1, (char)c) + ".");
       was_fsl = false;
     }
+    else if(was_dash) {
+      if(c == '>') res.push_back({ token_kind::IMPLIES, "" });
+      else throw parse_error("Invalid token -" + std::string(1, (char)c) + ".");
+      was_dash = false;
+    }
     else if(building) {
       if(!isalnum(c) && c != '_') {
         building = false;
@@ -92,6 +104,7 @@ std::vector<token> lex(std::istream &strm) {
         case '(': res.push_back({ token_kind::PAR_OPEN, "" }); break;
         case ')': res.push_back({ token_kind::PAR_CLOSE, "" }); break;
         case '/': was_fsl = true; break;
+        case '-': was_dash = true; break;
         case '!': res.push_back({ token_kind::NOT, "" }); break;
         default:
           if(isalnum(c) || c == '_') {
@@ -104,27 +117,25 @@ std::vector<token> lex(std::istream &strm) {
     }
   }
 
-  if(building) res.push_back({ token_kind::ATOM, curr });
+  if(building) {
+    if(curr == "true" || curr == "True" || curr == "TRUE") res.push_back({ token_kind::TRUE, "" });
+    else res.push_back({ token_kind::ATOM, curr });
+  }
 
-  bool was_exists = false;
+  // a quantifier directly followed by \\X, \\G or \\F is merged into that (unary) operator; any other quantifier opens
+  // an until
   for(size_t idx = 0; idx < res.size(); idx++) {
-    switch(res[idx].kind) {
-      case token_kind::EXISTS:
-        was_exists = true;
-        break;
-      case token_kind::NEXT:
-        if(!was_exists) throw parse_error("Encountered \\X without preceding \\E.");
-        res[idx - 1].kind = token_kind::IGNORE;
-        was_exists = false;
-        break;
-      case token_kind::GLOBALLY:
-        if(!was_exists) throw parse_error("Encountered \\G without preceding \\E.");
-        res[idx - 1].kind = token_kind::IGNORE;
-        was_exists = false;
-        break;
-      default:
-        was_exists = false;
-        break;
+    const token_kind k = res[idx].kind;
+    if(k != token_kind::NEXT && k != token_kind::GLOBALLY && k != token_kind::FUTURE) continue;
+    const token_kind q = idx == 0 ? token_kind::IGNORE : res[idx - 1].kind;
+    if(q != token_kind::EXISTS && q != token_kind::ALL) {
+      const char op = k == token_kind::NEXT ? 'X' : k == token_kind::GLOBALLY ? 'G' : 'F';
+      throw parse_error("Encountered \\" + std::string(1, op) + " without preceding \\E or \\A.");
+    }
+    res[idx - 1].kind = token_kind::IGNORE;
+    if(q == token_kind::ALL) {
+      res[idx].kind = k == token_kind::NEXT ? token_kind::A_NEXT : k == token_kind::GLOBALLY ? token_kind::A_GLOBALLY
+                                                                                             : token_kind::A_FUTURE;
     }
   }
   return res;
@@ -138,15 +149,25 @@ int prio(const token_kind t) {
     case token_kind::PAR_CLOSE:
     case token_kind::PAR_OPEN:
     case token_kind::EXISTS:
+    case token_kind::ALL:
       return -1;
     case token_kind::UNTIL:
+    case token_kind::A_UNTIL:
       return 1;
-    case token_kind::AND:
+    case token_kind::IMPLIES:
       return 2;
+    case token_kind::OR:
+      return 3;
+    case token_kind::AND:
+      return 4;
     case token_kind::NEXT:
     case token_kind::GLOBALLY:
+    case token_kind::FUTURE:
+    case token_kind::A_NEXT:
+    case token_kind::A_GLOBALLY:
+    case token_kind::A_FUTURE:
     case token_kind::NOT:
-      return 3;
+      return 5;
   }
 
   return -1;
@@ -160,12 +181,20 @@ int argc(const token_kind t) {
     case token_kind::NOT:
     case token_kind::NEXT:
     case token_kind::GLOBALLY:
+    case token_kind::FUTURE:
+    case token_kind::A_NEXT:
+    case token_kind::A_GLOBALLY:
+    case token_kind::A_FUTURE:
     case token_kind::PAR_OPEN:
     case token_kind::PAR_CLOSE:
       return 1;
     case token_kind::AND:
+    case token_kind::OR:
+    case token_kind::IMPLIES:
     case token_kind::EXISTS:
+    case token_kind::ALL:
     case token_kind::UNTIL:
+    case token_kind::A_UNTIL:
       return 2;
     case token_kind::IGNORE:
       return -1;
@@ -183,6 +212,14 @@ node_type to_node_type(const token_kind tk) {
     case token_kind::NEXT: return node_type::E_NEXT;
     case token_kind::UNTIL: return node_type::E_UNTIL;
     case token_kind::GLOBALLY: return node_type::E_ALWAYS;
+    case token_kind::FUTURE: return node_type::E_FUTURE;
+    case token_kind::OR: return node_type::DISJUNCTION;
+    case token_kind::IMPLIES: return node_type::IMPLICATION;
+    case token_kind::ALL: return node_type::A_UNTIL;
+    case token_kind::A_NEXT: return node_type::A_NEXT;
+    case token_kind::A_UNTIL: return node_type::A_UNTIL;
+    case token_kind::A_GLOBALLY: return node_type::A_ALWAYS;
+    case token_kind::A_FUTURE: return node_type::A_FUTURE;
     case token_kind::PAR_OPEN:
     case token_kind::PAR_CLOSE:
     case token_kind::IGNORE:
@@ -225,6 +262,15 @@ ctlf_node parser::parse(std::istream &strm) {
         break;
       case token_kind::PAR_OPEN:
       case token_kind::EXISTS:
+      case token_kind::ALL:
+      case token_kind::NOT:
+      case token_kind::NEXT:
+      case token_kind::GLOBALLY:
+      case token_kind::FUTURE:
+      case token_kind::A_NEXT:
+      case token_kind::A_GLOBALLY:
+      case token_kind::A_FUTURE:
+        // prefix operators have no left operand, so nothing on the stack can be applied yet
         operator_stack.push_back(token.kind);
         break;
       case token_kind::PAR_CLOSE:
@@ -234,16 +280,22 @@ ctlf_node parser::parse(std::istream &strm) {
         }
         operator_stack.pop_back();
         break;
-      case token_kind::UNTIL:
-        while(!operator_stack.empty() && operator_stack.back() != token_kind::EXISTS) {
+      case token_kind::UNTIL: {
+        while(!operator_stack.empty() && operator_stack.back() != token_kind::EXISTS && operator_stack.back() != token_kind::ALL) {
           apply(operator_stack.back());
           operator_stack.pop_back();
         }
+        if(operator_stack.empty()) throw parse_error("Encountered \\U without preceding \\E or \\A.");
+        const bool all = operator_stack.back() == token_kind::ALL;
         operator_stack.pop_back();
-        operator_stack.push_back(token.kind);
+        operator_stack.push_back(all ? token_kind::A_UNTIL : token_kind::UNTIL);
         break;
+      }
       default:
-        while(!operator_stack.empty() && operator_stack.back() != token_kind::PAR_OPEN && prio(operator_stack.back()) >= prio(token.kind)) {
+        // -> is right-associative, the other binary operators are left-associative
+        while(!operator_stack.empty() && operator_stack.back() != token_kind::PAR_OPEN &&
+              (prio(operator_stack.back()) > prio(token.kind) ||
+               (prio(operator_stack.back()) == prio(token.kind) && token.kind != token_kind::IMPLIES))) {
           apply(operator_stack.back());
           operator_stack.pop_back();
         }
@@ -267,10 +319,14 @@ ctlf_node parser::parse(std::istream &strm) {
  expr::= True
        | IDENT[id]
        | ! <expr>
-       | \E \X <expr>
-       | \E \G <expr>
+       | \E \X <expr> | \A \X <expr>
+       | \E \G <expr> | \A \G <expr>
+       | \E \F <expr> | \A \F <expr>
        | <expr> /\ <expr>
+       | <expr> \/ <expr>
+       | <expr> -> <expr>
        | \E <expr> \U <expr>
+       | \A <expr> \U <expr>
        | ( <expr> )
 
 
@@ -0,0 +1,27 @@
+//
+// Created by jay on 7/28/23.
+//
+
+#include <algorithm>
+#include "graph/bit_matrix.hpp"
+
+using namespace ctl::graph;
+
+void bit_matrix::reserve(size_t size) {
+  if(size <= capacity) return;
+
+  const size_t new_stride = (size + state_set::word_bits - 1) / state_set::word_bits;
+  std::vector<word> grown(size * new_stride, 0);
+  for(size_t r = 0; r < n; r++) {
+    std::copy_n(bits.begin() + (ptrdiff_t)(r * stride), stride, grown.begin() + (ptrdiff_t)(r * new_stride));
+  }
+  bits.swap(grown);
+  capacity = size;
+  stride = new_stride;
+}
+
+void bit_matrix::grow(size_t size) {
+  if(size <= n) return;
+  if(size > capacity) reserve(std::max(size, 2 * capacity));
+  n = size;
+}
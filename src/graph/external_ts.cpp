@@ -0,0 +1,128 @@
+//
+// Created by jay on 8/7/23.
+//
+
+#include <algorithm>
+#include "graph/external_ts.hpp"
+#include "exceptions.hpp"
+
+using namespace ctl;
+using namespace ctl::graph;
+
+namespace {
+// Entries of the offset arrays read at once while splitting the edges into blocks.
+constexpr size_t scan_chunk = size_t{1} << 16;
+
+void check_states(const auto &states, std::uint64_t n) {
+  if(!std::ranges::all_of(states, [n](std::uint64_t s) { return s < n; })) {
+    throw parse_error("Binary TS file is corrupt (state out of range)");
+  }
+}
+}
+
+external_ts::external_ts(const std::string &path, size_t block_bytes) : file{path} {
+  if(file.size() < sizeof(hdr)) throw parse_error("Binary TS file is truncated (no header)");
+  file.read(&hdr, sizeof(hdr), 0);
+  mapped_ts::validate(hdr, file.size());
+
+  const size_t n = hdr.states;
+  const size_t words_per_label = (n + state_set::word_bits - 1) / state_set::word_bits;
+  auto check = [this](std::uint64_t offset, std::uint64_t count, std::uint64_t elem) {
+    if(offset % 8 != 0 || offset > file.size() || count > (file.size() - offset) / elem) {
+      throw parse_error("Binary TS file is truncated or corrupt (section out of bounds)");
+    }
+  };
+  check(hdr.fwd_offsets, n + 1, sizeof(std::uint64_t));
+  check(hdr.fwd_targets, hdr.edges, sizeof(state_id));
+  check(hdr.labels, hdr.props * words_per_label, sizeof(state_set::word));
+  check(hdr.initial_states, hdr.initial, sizeof(std::uint64_t));
+  check(hdr.accepting_states, hdr.accepting, sizeof(std::uint64_t));
+  check(hdr.name_offsets, n + hdr.props + 1, sizeof(std::uint64_t));
+  check(hdr.names, hdr.names_bytes, 1);
+
+  // split the forward edges into blocks of consecutive states, in one pass over the offsets
+  const std::uint64_t max_edges = std::max<std::uint64_t>(1, block_bytes / sizeof(state_id));
+  const std::uint64_t max_states = std::max<std::uint64_t>(1, block_bytes / sizeof(std::uint64_t));
+  std::vector<std::uint64_t> offsets;
+  block curr{ 0, 0, 0, 0 };
+  for(size_t first = 0; first < n; first += scan_chunk) {
+    const size_t last = std::min(n, first + scan_chunk);
+    offsets.resize(last - first + 1);
+    read_section(hdr.fwd_offsets, first, offsets.size(), offsets.data());
+    if(first == 0 && offsets[0] != 0) throw parse_error("Binary TS file is corrupt (inconsistent section sizes)");
+    for(size_t s = first; s < last; s++) {
+      const std::uint64_t end = offsets[s - first + 1];
+      if(end < offsets[s - first]) throw parse_error("Binary TS file is corrupt (inconsistent section sizes)");
+      if(curr.last > curr.first && (end - curr.edges_begin > max_edges || curr.last - curr.first >= max_states)) {
+        parts.push_back(curr);
+        curr = { s, s, curr.edges_end, curr.edges_end };
+      }
+      curr.last = s + 1;
+      curr.edges_end = end;
+    }
+  }
+  if(curr.last > curr.first) parts.push_back(curr);
+  if(curr.edges_end != hdr.edges) throw parse_error("Binary TS file is corrupt (inconsistent section sizes)");
+
+  std::vector<state_set::word> words(words_per_label);
+  for(prop_id id = 0; id < hdr.props; id++) {
+    read_section(hdr.labels, id * words_per_label, words_per_label, words.data());
+    labels.emplace_back(std::span<const state_set::word>(words), n);
+  }
+  initial_states.resize(hdr.initial);
+  read_section(hdr.initial_states, 0, hdr.initial, initial_states.data());
+  accepting_states.resize(hdr.accepting);
+  read_section(hdr.accepting_states, 0, hdr.accepting, accepting_states.data());
+  check_states(initial_states, n);
+  check_states(accepting_states, n);
+
+  // only the proposition names are needed up front; they come after the state names
+  std::string chars;
+  read_names(n, n + hdr.props, offsets, chars);
+  if(offsets.back() != hdr.names_bytes) throw parse_error("Binary TS file is corrupt (inconsistent section sizes)");
+  for(prop_id id = 0; id < hdr.props; id++) {
+    props.intern(prop(chars.substr(offsets[id] - offsets[0], offsets[id + 1] - offsets[id])));
+  }
+}
+
+void external_ts::read(const block &b, block_data &out) const {
+  out.first = b.first;
+  out.offsets.resize(b.last - b.first + 1);
+  read_section(hdr.fwd_offsets, b.first, out.offsets.size(), out.offsets.data());
+  out.targets.resize(b.edges_end - b.edges_begin);
+  read_section(hdr.fwd_targets, b.edges_begin, out.targets.size(), out.targets.data());
+  // the edges are never loaded as a whole, so each block is validated as it is read
+  if(out.offsets.front() != b.edges_begin || out.offsets.back() != b.edges_end || !std::ranges::is_sorted(out.offsets)) {
+    throw parse_error("Binary TS file is corrupt (inconsistent section sizes)");
+  }
+  check_states(out.targets, hdr.states);
+}
+
+bool external_ts::any_in(const state_set &s, size_t first, size_t last) {
+  return first < last && *state_set::iterator(s.words().data(), last, first) != last;
+}
+
+void external_ts::prefetch(const block &b) const {
+  file.will_need(hdr.fwd_offsets + b.first * sizeof(std::uint64_t), (b.last - b.first + 1) * sizeof(std::uint64_t));
+  file.will_need(hdr.fwd_targets + b.edges_begin * sizeof(state_id), (b.edges_end - b.edges_begin) * sizeof(state_id));
+}
+
+void external_ts::read_names(size_t first, size_t last, std::vector<std::uint64_t> &offsets, std::string &chars) const {
+  offsets.resize(last - first + 1);
+  read_section(hdr.name_offsets, first, offsets.size(), offsets.data());
+  if(offsets.back() > hdr.names_bytes || !std::ranges::is_sorted(offsets)) {
+    throw parse_error("Binary TS file is corrupt (inconsistent section sizes)");
+  }
+  chars.resize(offsets.back() - offsets[0]);
+  read_section(hdr.names, offsets[0], chars.size(), chars.data());
+}
+
+template <typename T>
+void external_ts::read_section(std::uint64_t offset, std::uint64_t index, std::uint64_t count, T *dst) const {
+  if(count == 0) return;
+  const std::uint64_t available = offset > file.size() ? 0 : (file.size() - offset) / sizeof(T);
+  if(index > available || count > available - index) {
+    throw parse_error("Binary TS file is truncated or corrupt (section out of bounds)");
+  }
+  file.read(dst, count * sizeof(T), offset + index * sizeof(T));
+}
@@ -5,9 +5,14 @@
 
 #include <unordered_map>
 #include <unordered_set>
+#include <string_view>
+#include <algorithm>
+#include <cstdint>
 #include "util.hpp"
 #include "graph/graph_reader.hpp"
 #include "exceptions.hpp"
+#include "mapped_file.hpp"
+#include "thread_pool.hpp"
 
 using namespace ctl;
 using namespace ctl::graph;
@@ -76,7 +81,7 @@ default_ts graph_reader::parse(std::istream &strm) {
       const auto &[s, e] = parse_trans(line.substr(6), lineno);
       if(!nodes.contains(s)) throw parse_error("Use of undefined node `" + s + "' (at line " + std::to_string(lineno) + ")");
       if(!nodes.contains(e)) throw parse_error("Use of undefined node `" + e + "' (at line " + std::to_string(lineno) + ")");
-      res.add_transition(nodes[s], nodes[e]);
+      res.add_edge(nodes[s], nodes[e]);
     }
     else {
       auto f = line.find(' ');
@@ -84,5 +89,299 @@ default_ts graph_reader::parse(std::istream &strm) {
     }
   }
 
+  res.freeze();
   return res;
-}
\ No newline at end of file
+}
+
+namespace {
+constexpr size_t no_line = (size_t)-1;
+constexpr size_t min_chunk_bytes = size_t{1} << 20;
+
+inline bool is_ws(char c) { return isspace((unsigned char)c) != 0; }
+
+void split_ws(std::string_view s, std::vector<std::string_view> &out) {
+  out.clear();
+  size_t i = 0;
+  while(true) {
+    while(i < s.size() && is_ws(s[i])) i++;
+    if(i == s.size()) return;
+    const size_t start = i;
+    while(i < s.size() && !is_ws(s[i])) i++;
+    out.push_back(s.substr(start, i - start));
+  }
+}
+
+std::string_view strip(std::string_view s) {
+  while(!s.empty() && is_ws(s.front())) s.remove_prefix(1);
+  while(!s.empty() && is_ws(s.back())) s.remove_suffix(1);
+  return s;
+}
+
+struct node_rec {
+  std::string_view name;
+  bool is_init;
+  bool is_accept;
+  size_t props_begin;
+  size_t props_end;
+  size_t line;
+};
+
+struct trans_rec {
+  std::string_view src;
+  std::string_view dst;
+  size_t line;
+};
+
+// One chunk of whole lines. Line numbers in the records are local to the chunk until the chunks are stitched together.
+struct chunk {
+  std::string_view text;
+  size_t newlines = 0;
+  size_t first_line = 1;
+  std::vector<node_rec> nodes;
+  std::vector<std::string_view> props;
+  std::vector<trans_rec> trans;
+  std::vector<std::pair<size_t, size_t>> edges;
+  size_t err_line = no_line;
+  std::string err; // without the " (at line N)" suffix
+
+  inline void fail(size_t line, std::string msg) {
+    err_line = line;
+    err = std::move(msg);
+  }
+
+  bool parse_node(std::string_view s, size_t line, std::vector<std::string_view> &tokens) {
+    const size_t open = s.find('(');
+    if(open == std::string_view::npos) { fail(line, "Unexpected <EOL> (missing opening parenthesis)"); return false; }
+    if(s.find('(', open + 1) != std::string_view::npos) { fail(line, "Unexpected `('"); return false; }
+    split_ws(s.substr(0, open), tokens);
+    if(tokens.empty()) {
+      fail(line, "Unexpected <EOL>, expected `INITIAL', `ACCEPTING' or <name> (NODE (INITIAL|ACCEPTING)* <name> (props))");
+      return false;
+    }
+
+    node_rec rec{ {}, false, false, props.size(), 0, line };
+    bool hit_end = false;
+    for(const auto tok: tokens) {
+      if(!hit_end) {
+        if(tok == "INITIAL") rec.is_init = true;
+        else if(tok == "ACCEPTING") rec.is_accept = true;
+        else {
+          rec.name = tok;
+          hit_end = true;
+        }
+      }
+      else {
+        fail(line, "Unexpected token `" + std::string(tok) + "', expected `('");
+        return false;
+      }
+    }
+
+    // like parse, drop the last character (the closing parenthesis) without looking at it
+    auto r = s.substr(open + 1);
+    if(!r.empty()) r.remove_suffix(1);
+    while(true) {
+      const size_t comma = r.find(',');
+      const auto tok = strip(r.substr(0, comma));
+      if(tok.empty()) {
+        props.resize(rec.props_begin);
+        fail(line, "Invalid atomic proposition (empty)");
+        return false;
+      }
+      props.push_back(tok);
+      if(comma == std::string_view::npos) break;
+      r.remove_prefix(comma + 1);
+    }
+    rec.props_end = props.size();
+    nodes.push_back(rec);
+    return true;
+  }
+
+  bool parse_trans(std::string_view s, size_t line, std::vector<std::string_view> &tokens) {
+    split_ws(s, tokens);
+    if(tokens.size() != 3) { fail(line, "Invalid transition definition. Expected <start> -> <end>"); return false; }
+    if(tokens[1] != "->") { fail(line, "Unexpected token `" + std::string(tokens[1]) + "'. Expected `->'"); return false; }
+    trans.push_back(trans_rec{ tokens[0], tokens[2], line });
+    return true;
+  }
+
+  void parse() {
+    std::vector<std::string_view> tokens;
+    std::string_view rest = text;
+    size_t line = 0;
+    while(!rest.empty()) {
+      const size_t eol = rest.find('\n');
+      const auto curr = rest.substr(0, eol);
+      rest.remove_prefix(eol == std::string_view::npos ? rest.size() : eol + 1);
+      ++line;
+
+      if(curr.starts_with("// ") || curr.empty()) continue;
+      else if(curr.starts_with("NODE ")) {
+        if(!parse_node(curr.substr(5), line, tokens)) return;
+      }
+      else if(curr.starts_with("TRANS ")) {
+        if(!parse_trans(curr.substr(6), line, tokens)) return;
+      }
+      else {
+        fail(line, "Invalid command `" + std::string(curr.substr(0, curr.find(' '))) + "'");
+        return;
+      }
+    }
+  }
+};
+
+// Open-addressing (linear probing) index from node names to their state and the line they were defined on. The
+// names are views into the mapped file, so nothing is copied.
+class name_index {
+public:
+  struct entry {
+    std::uint64_t hash = 0;
+    std::string_view name;
+    size_t idx = no_line;
+    size_t line = no_line;
+  };
+
+  explicit name_index(size_t expected) {
+    size_t cap = 16;
+    while(cap < 2 * expected) cap *= 2;
+    slots.resize(cap);
+    mask = cap - 1;
+  }
+
+  // Returns the entry that was already there if the name is known, or nullptr after inserting it.
+  const entry *insert(std::string_view name, size_t idx, size_t line) {
+    const auto h = hash(name);
+    for(size_t i = h & mask;; i = (i + 1) & mask) {
+      auto &e = slots[i];
+      if(e.idx == no_line) {
+        e = entry{ h, name, idx, line };
+        return nullptr;
+      }
+      if(e.hash == h && e.name == name) return &e;
+    }
+  }
+
+  [[nodiscard]] const entry *find(std::string_view name) const {
+    const auto h = hash(name);
+    for(size_t i = h & mask;; i = (i + 1) & mask) {
+      const auto &e = slots[i];
+      if(e.idx == no_line) return nullptr;
+      if(e.hash == h && e.name == name) return &e;
+    }
+  }
+
+private:
+  static inline std::uint64_t hash(std::string_view s) {
+    // FNV-1a, finished with a multiplicative mix so the low bits (used for the slot) depend on every byte
+    std::uint64_t h = 0xCBF29CE484222325ull;
+    for(const char c: s) h = (h ^ (unsigned char)c) * 0x100000001B3ull;
+    return (h ^ (h >> 32)) * 0x9E3779B97F4A7C15ull;
+  }
+
+  std::vector<entry> slots;
+  size_t mask;
+};
+
+std::vector<chunk> split_chunks(std::string_view text, size_t max_chunks) {
+  const size_t count = std::max<size_t>(1, std::min(max_chunks, text.size() / min_chunk_bytes));
+  std::vector<chunk> res;
+  size_t start = 0;
+  for(size_t i = 1; i <= count && start < text.size(); i++) {
+    size_t end = i == count ? text.size() : std::max(start, text.size() * i / count);
+    if(end < text.size()) {
+      const size_t eol = text.find('\n', end);
+      end = eol == std::string_view::npos ? text.size() : eol + 1;
+    }
+    res.emplace_back();
+    res.back().text = text.substr(start, end - start);
+    start = end;
+  }
+  return res;
+}
+}
+
+default_ts graph_reader::parse_file(const std::string &path, size_t threads) {
+  mapped_file file(path);
+  thread_pool pool(threads);
+  auto chunks = split_chunks(file.view(), pool.size() * 4);
+
+  pool.parallel_for(chunks.size(), [&chunks](size_t c) {
+    auto &ch = chunks[c];
+    ch.newlines = (size_t)std::count(ch.text.begin(), ch.text.end(), '\n');
+    ch.parse();
+  });
+
+  // stitch the chunks together: global line numbers, then the earliest syntax error (parsing stops at the first one
+  // in each chunk, so nothing after it matters)
+  size_t err_line = no_line;
+  std::string err;
+  size_t used = 0;
+  for(size_t line = 1; used < chunks.size(); used++) {
+    auto &ch = chunks[used];
+    ch.first_line = line;
+    line += ch.newlines;
+    for(auto &n: ch.nodes) n.line += ch.first_line - 1;
+    for(auto &t: ch.trans) t.line += ch.first_line - 1;
+    if(ch.err_line != no_line) {
+      err_line = ch.err_line + ch.first_line - 1;
+      err = ch.err;
+      used++;
+      break;
+    }
+  }
+
+  size_t node_count = 0;
+  for(size_t c = 0; c < used; c++) node_count += chunks[c].nodes.size();
+  name_index names(node_count);
+  size_t idx = 0;
+  for(size_t c = 0; c < used && idx != no_line; c++) {
+    for(const auto &n: chunks[c].nodes) {
+      if(names.insert(n.name, idx++, n.line) != nullptr) {
+        if(n.line < err_line) {
+          err_line = n.line;
+          err = "Cannot redefine node " + std::string(n.name);
+        }
+        idx = no_line;
+        break;
+      }
+    }
+  }
+
+  // a transition may only use nodes declared on an earlier line
+  pool.parallel_for(used, [&chunks, &names](size_t c) {
+    auto &ch = chunks[c];
+    ch.err_line = no_line;
+    ch.edges.reserve(ch.trans.size());
+    for(const auto &t: ch.trans) {
+      const auto *s = names.find(t.src);
+      if(s == nullptr || s->line > t.line) { ch.fail(t.line, "Use of undefined node `" + std::string(t.src) + "'"); return; }
+      const auto *e = names.find(t.dst);
+      if(e == nullptr || e->line > t.line) { ch.fail(t.line, "Use of undefined node `" + std::string(t.dst) + "'"); return; }
+      ch.edges.emplace_back(s->idx, e->idx);
+    }
+  });
+  for(size_t c = 0; c < used; c++) {
+    if(chunks[c].err_line < err_line) {
+      err_line = chunks[c].err_line;
+      err = chunks[c].err;
+    }
+  }
+  if(err_line != no_line) throw parse_error(err + " (at line " + std::to_string(err_line) + ")");
+
+  default_ts res;
+  for(const auto &ch: chunks) {
+    for(const auto &n: ch.nodes) {
+      std::unordered_set<prop> atomics;
+      for(size_t p = n.props_begin; p < n.props_end; p++) atomics.emplace(ch.props[p]);
+      res.add(n.name, std::move(atomics), n.is_init, n.is_accept);
+    }
+  }
+  size_t edge_count = 0;
+  for(const auto &ch: chunks) edge_count += ch.edges.size();
+  res.reserve_edges(edge_count);
+  for(const auto &ch: chunks) {
+    for(const auto &[s, e]: ch.edges) res.add_edge(s, e);
+  }
+
+  res.freeze(&pool);
+  return res;
+}
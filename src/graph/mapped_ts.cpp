@@ -0,0 +1,131 @@
+//
+// Created by jay on 7/27/23.
+//
+
+#include <cstring>
+#include <algorithm>
+#include "graph/mapped_ts.hpp"
+#include "exceptions.hpp"
+
+using namespace ctl;
+using namespace ctl::graph;
+
+mapped_ts::mapped_ts(const std::string &path) : file{std::make_unique<mapped_file>(path)} {
+  if(file->size() < sizeof(header)) throw parse_error("Binary TS file is truncated (no header)");
+  hdr = (const header *)file->data();
+  validate(*hdr, file->size());
+
+  const size_t n = hdr->states;
+  words_per_label = (n + state_set::word_bits - 1) / state_set::word_bits;
+  fwd_offsets = section<size_t>(hdr->fwd_offsets, n + 1);
+  fwd_targets = section<state_id>(hdr->fwd_targets, hdr->edges);
+  bwd_offsets = section<size_t>(hdr->bwd_offsets, n + 1);
+  bwd_targets = section<state_id>(hdr->bwd_targets, hdr->edges);
+  label_words = section<state_set::word>(hdr->labels, hdr->props * words_per_label);
+  initial_states = section<size_t>(hdr->initial_states, hdr->initial);
+  accepting_states = section<size_t>(hdr->accepting_states, hdr->accepting);
+  name_offsets = section<std::uint64_t>(hdr->name_offsets, n + hdr->props + 1);
+  names = { section<char>(hdr->names, hdr->names_bytes).data(), hdr->names_bytes };
+
+  // only what can be checked without touching the big sections; verify() scans the rest
+  if(fwd_offsets[0] != 0 || fwd_offsets[n] != hdr->edges || bwd_offsets[0] != 0 || bwd_offsets[n] != hdr->edges ||
+     name_offsets[0] != 0 || name_offsets[n + hdr->props] != hdr->names_bytes) {
+    throw parse_error("Binary TS file is corrupt (inconsistent section sizes)");
+  }
+
+  for(prop_id id = 0; id < hdr->props; id++) {
+    const auto begin = name_offsets[n + id], end = name_offsets[n + id + 1];
+    if(end < begin || end > hdr->names_bytes) throw parse_error("Binary TS file is corrupt (inconsistent section sizes)");
+    props.intern(prop(names.substr(begin, end - begin)));
+  }
+}
+
+void mapped_ts::verify() const {
+  const size_t n = hdr->states;
+  if(!std::ranges::is_sorted(fwd_offsets) || !std::ranges::is_sorted(bwd_offsets) || !std::ranges::is_sorted(name_offsets)) {
+    throw parse_error("Binary TS file is corrupt (inconsistent section sizes)");
+  }
+
+  auto in_range = [n](const auto &states) {
+    return std::ranges::all_of(states, [n](size_t s) { return s < n; });
+  };
+  if(!in_range(fwd_targets) || !in_range(bwd_targets) || !in_range(initial_states) || !in_range(accepting_states)) {
+    throw parse_error("Binary TS file is corrupt (state out of range)");
+  }
+}
+
+void mapped_ts::validate(const header &h, std::uint64_t file_size) {
+  if(std::memcmp(h.magic, magic, sizeof(magic)) != 0) throw parse_error("Not a binary TS file (bad magic)");
+  if(h.byte_order != byte_order) throw parse_error("Binary TS file was written with a different byte order");
+  if(h.version != format_version) {
+    throw parse_error("Unsupported binary TS format version " + std::to_string(h.version) + " (expected " +
+                      std::to_string(format_version) + ")");
+  }
+
+  if(h.states > std::numeric_limits<state_id>::max()) throw parse_error("Binary TS file has too many states");
+  // every state, proposition and initial/accepting state takes at least one 64-bit entry in some section, every edge
+  // a 32-bit one
+  const std::uint64_t entries = file_size / sizeof(std::uint64_t);
+  const std::uint64_t words_per_label = (h.states + state_set::word_bits - 1) / state_set::word_bits;
+  if(h.states >= entries || h.edges > file_size / sizeof(state_id) || h.props >= entries || h.initial > entries ||
+     h.accepting > entries || h.names_bytes > file_size || (h.props != 0 && words_per_label > entries / h.props)) {
+    throw parse_error("Binary TS file is truncated or corrupt (section out of bounds)");
+  }
+}
+
+bool mapped_ts::is_binary(const std::string &path) {
+  std::ifstream strm(path, std::ios::binary);
+  char buf[sizeof(magic)] = {};
+  strm.read(buf, sizeof(buf));
+  return strm.gcount() == sizeof(buf) && std::memcmp(buf, magic, sizeof(magic)) == 0;
+}
+
+template <typename T>
+std::span<const T> mapped_ts::section(std::uint64_t offset, std::uint64_t count) const {
+  if(offset % alignof(T) != 0 || offset > file->size() || count > (file->size() - offset) / sizeof(T)) {
+    throw parse_error("Binary TS file is truncated or corrupt (section out of bounds)");
+  }
+  return { (const T *)(file->data() + offset), count };
+}
+
+mapped_ts::writer::writer(const std::string &path) : out(path, std::ios::binary | std::ios::trunc) {
+  if(!out.good()) throw std::runtime_error("can't open file " + path + " for writing");
+  const header placeholder{};
+  out.write((const char *)&placeholder, sizeof(placeholder));
+  pos = sizeof(placeholder);
+}
+
+std::uint64_t mapped_ts::writer::section() {
+  static constexpr char zeros[8] = {};
+  const std::uint64_t pad = (8 - pos % 8) % 8;
+  out.write(zeros, (std::streamsize)pad);
+  pos += pad;
+  return pos;
+}
+
+void mapped_ts::writer::put(std::uint64_t v) {
+  out.write((const char *)&v, sizeof(v));
+  pos += sizeof(v);
+}
+
+void mapped_ts::writer::put(std::uint32_t v) {
+  out.write((const char *)&v, sizeof(v));
+  pos += sizeof(v);
+}
+
+void mapped_ts::writer::put(std::span<const std::uint64_t> vs) {
+  out.write((const char *)vs.data(), (std::streamsize)vs.size_bytes());
+  pos += vs.size_bytes();
+}
+
+void mapped_ts::writer::put(std::string_view s) {
+  out.write(s.data(), (std::streamsize)s.size());
+  pos += s.size();
+}
+
+void mapped_ts::writer::finish(header h) {
+  out.seekp(0);
+  out.write((const char *)&h, sizeof(h));
+  out.flush();
+  if(!out.good()) throw std::runtime_error("failed to write binary TS file");
+}
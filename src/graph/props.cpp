@@ -0,0 +1,41 @@
+//
+// Created by jay on 7/11/23.
+//
+
+#include <algorithm>
+#include "graph/props.hpp"
+
+using namespace ctl::graph;
+
+prop_id prop_table::intern(const prop &p) {
+  auto [it, inserted] = ids.try_emplace(p, names.size());
+  if(inserted) names.push_back(p);
+  return it->second;
+}
+
+prop_id prop_table::find(const prop &p) const {
+  auto it = ids.find(p);
+  return it == ids.end() ? npos : it->second;
+}
+
+void labelling::add(size_t state, const prop &p) {
+  prop_id id = props.intern(p);
+  if(id == columns.size()) columns.emplace_back();
+
+  auto &col = columns[id];
+  if(col.size() <= state) col.resize(std::max(state + 1, 2 * col.size()));
+  col.insert(state);
+}
+
+void labelling::remove(size_t state, const prop &p) {
+  const prop_id id = props.find(p);
+  if(id != prop_table::npos && state < columns[id].size()) columns[id].erase(state);
+}
+
+std::vector<prop_id> labelling::of(size_t state) const {
+  std::vector<prop_id> res;
+  for(prop_id id = 0; id < columns.size(); id++) {
+    if(state < columns[id].size() && columns[id].contains(state)) res.push_back(id);
+  }
+  return res;
+}
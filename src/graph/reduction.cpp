@@ -0,0 +1,27 @@
+//
+// Created by jay on 8/4/23.
+//
+
+#include "graph/reduction.hpp"
+
+using namespace ctl::graph;
+
+state_set reduction::lift(const state_set &s) const {
+  state_set res(image.size());
+  for(size_t v = 0; v < image.size(); v++) {
+    if(image[v] != npos && s.contains(image[v])) res.insert(v);
+  }
+  return res;
+}
+
+size_t reduction::kept() const {
+  return image.size() - std::ranges::count(image, npos);
+}
+
+reduction ctl::graph::compose(const reduction &first, reduction second) {
+  std::vector<size_t> image(first.image.size(), reduction::npos);
+  for(size_t v = 0; v < image.size(); v++) {
+    if(first.image[v] != reduction::npos) image[v] = second.image[first.image[v]];
+  }
+  return { .ts = std::move(second.ts), .image = std::move(image) };
+}
@@ -0,0 +1,283 @@
+//
+// Created by jay on 7/9/23.
+//
+
+#include <algorithm>
+#include "graph/state_set.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CTL_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+using namespace ctl::graph;
+using word = state_set::word;
+
+namespace {
+// scalar fallbacks, used for the tails of the vectorized kernels as well
+void and_scalar(word *dst, const word *src, size_t n) { for(size_t i = 0; i < n; i++) dst[i] &= src[i]; }
+void or_scalar(word *dst, const word *src, size_t n) { for(size_t i = 0; i < n; i++) dst[i] |= src[i]; }
+void andnot_scalar(word *dst, const word *src, size_t n) { for(size_t i = 0; i < n; i++) dst[i] &= ~src[i]; }
+void not_scalar(word *dst, size_t n) { for(size_t i = 0; i < n; i++) dst[i] = ~dst[i]; }
+bool any_scalar(const word *src, size_t n) {
+  for(size_t i = 0; i < n; i++) if(src[i]) return true;
+  return false;
+}
+bool intersects_scalar(const word *one, const word *other, size_t n) {
+  for(size_t i = 0; i < n; i++) if(one[i] & other[i]) return true;
+  return false;
+}
+size_t count_scalar(const word *src, size_t n) {
+  size_t res = 0;
+  for(size_t i = 0; i < n; i++) res += (size_t)__builtin_popcountll(src[i]);
+  return res;
+}
+
+#ifdef CTL_X86_KERNELS
+__attribute__((target("avx2"))) void and_avx2(word *dst, const word *src, size_t n) {
+  size_t i = 0;
+  for(; i + 4 <= n; i += 4) {
+    auto a = _mm256_loadu_si256((const __m256i *)(dst + i));
+    auto b = _mm256_loadu_si256((const __m256i *)(src + i));
+    _mm256_storeu_si256((__m256i *)(dst + i), _mm256_and_si256(a, b));
+  }
+  and_scalar(dst + i, src + i, n - i);
+}
+
+__attribute__((target("avx2"))) void or_avx2(word *dst, const word *src, size_t n) {
+  size_t i = 0;
+  for(; i + 4 <= n; i += 4) {
+    auto a = _mm256_loadu_si256((const __m256i *)(dst + i));
+    auto b = _mm256_loadu_si256((const __m256i *)(src + i));
+    _mm256_storeu_si256((__m256i *)(dst + i), _mm256_or_si256(a, b));
+  }
+  or_scalar(dst + i, src + i, n - i);
+}
+
+__attribute__((target("avx2"))) void andnot_avx2(word *dst, const word *src, size_t n) {
+  size_t i = 0;
+  for(; i + 4 <= n; i += 4) {
+    auto a = _mm256_loadu_si256((const __m256i *)(dst + i));
+    auto b = _mm256_loadu_si256((const __m256i *)(src + i));
+    _mm256_storeu_si256((__m256i *)(dst + i), _mm256_andnot_si256(b, a));
+  }
+  andnot_scalar(dst + i, src + i, n - i);
+}
+
+__attribute__((target("avx2"))) void not_avx2(word *dst, size_t n) {
+  size_t i = 0;
+  const auto ones = _mm256_set1_epi64x(-1);
+  for(; i + 4 <= n; i += 4) {
+    auto a = _mm256_loadu_si256((const __m256i *)(dst + i));
+    _mm256_storeu_si256((__m256i *)(dst + i), _mm256_xor_si256(a, ones));
+  }
+  not_scalar(dst + i, n - i);
+}
+
+__attribute__((target("avx2"))) bool any_avx2(const word *src, size_t n) {
+  size_t i = 0;
+  for(; i + 4 <= n; i += 4) {
+    auto a = _mm256_loadu_si256((const __m256i *)(src + i));
+    if(!_mm256_testz_si256(a, a)) return true;
+  }
+  return any_scalar(src + i, n - i);
+}
+
+__attribute__((target("avx2"))) bool intersects_avx2(const word *one, const word *other, size_t n) {
+  size_t i = 0;
+  for(; i + 4 <= n; i += 4) {
+    auto a = _mm256_loadu_si256((const __m256i *)(one + i));
+    auto b = _mm256_loadu_si256((const __m256i *)(other + i));
+    if(!_mm256_testz_si256(a, b)) return true;
+  }
+  return intersects_scalar(one + i, other + i, n - i);
+}
+
+__attribute__((target("popcnt"))) size_t count_popcnt(const word *src, size_t n) {
+  size_t res = 0;
+  for(size_t i = 0; i < n; i++) res += (size_t)_mm_popcnt_u64(src[i]);
+  return res;
+}
+
+__attribute__((target("avx512f"))) void and_avx512(word *dst, const word *src, size_t n) {
+  size_t i = 0;
+  for(; i + 8 <= n; i += 8) {
+    auto a = _mm512_loadu_si512(dst + i);
+    auto b = _mm512_loadu_si512(src + i);
+    _mm512_storeu_si512(dst + i, _mm512_and_si512(a, b));
+  }
+  and_scalar(dst + i, src + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void or_avx512(word *dst, const word *src, size_t n) {
+  size_t i = 0;
+  for(; i + 8 <= n; i += 8) {
+    auto a = _mm512_loadu_si512(dst + i);
+    auto b = _mm512_loadu_si512(src + i);
+    _mm512_storeu_si512(dst + i, _mm512_or_si512(a, b));
+  }
+  or_scalar(dst + i, src + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void andnot_avx512(word *dst, const word *src, size_t n) {
+  size_t i = 0;
+  for(; i + 8 <= n; i += 8) {
+    auto a = _mm512_loadu_si512(dst + i);
+    auto b = _mm512_loadu_si512(src + i);
+    // 0x30 is the truth table of A & ~B (C is ignored); unlike _mm512_andnot_si512 it needs no undefined vector
+    _mm512_storeu_si512(dst + i, _mm512_ternarylogic_epi64(a, b, b, 0x30));
+  }
+  andnot_scalar(dst + i, src + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void not_avx512(word *dst, size_t n) {
+  size_t i = 0;
+  const auto ones = _mm512_set1_epi64(-1);
+  for(; i + 8 <= n; i += 8) {
+    auto a = _mm512_loadu_si512(dst + i);
+    _mm512_storeu_si512(dst + i, _mm512_xor_si512(a, ones));
+  }
+  not_scalar(dst + i, n - i);
+}
+
+__attribute__((target("avx512f"))) bool any_avx512(const word *src, size_t n) {
+  size_t i = 0;
+  for(; i + 8 <= n; i += 8) {
+    auto a = _mm512_loadu_si512(src + i);
+    if(_mm512_test_epi64_mask(a, a)) return true;
+  }
+  return any_scalar(src + i, n - i);
+}
+
+__attribute__((target("avx512f"))) bool intersects_avx512(const word *one, const word *other, size_t n) {
+  size_t i = 0;
+  for(; i + 8 <= n; i += 8) {
+    auto a = _mm512_loadu_si512(one + i);
+    auto b = _mm512_loadu_si512(other + i);
+    if(_mm512_test_epi64_mask(a, b)) return true;
+  }
+  return intersects_scalar(one + i, other + i, n - i);
+}
+#endif
+
+struct kernel_table {
+  void (*and_w)(word *, const word *, size_t) = and_scalar;
+  void (*or_w)(word *, const word *, size_t) = or_scalar;
+  void (*andnot_w)(word *, const word *, size_t) = andnot_scalar;
+  void (*not_w)(word *, size_t) = not_scalar;
+  bool (*any_w)(const word *, size_t) = any_scalar;
+  bool (*intersects_w)(const word *, const word *, size_t) = intersects_scalar;
+  size_t (*count_w)(const word *, size_t) = count_scalar;
+
+  kernel_table() {
+#ifdef CTL_X86_KERNELS
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("popcnt")) count_w = count_popcnt;
+    if(__builtin_cpu_supports("avx512f")) {
+      and_w = and_avx512; or_w = or_avx512; andnot_w = andnot_avx512; not_w = not_avx512;
+      any_w = any_avx512; intersects_w = intersects_avx512;
+    }
+    else if(__builtin_cpu_supports("avx2")) {
+      and_w = and_avx2; or_w = or_avx2; andnot_w = andnot_avx2; not_w = not_avx2;
+      any_w = any_avx2; intersects_w = intersects_avx2;
+    }
+#endif
+  }
+};
+
+const kernel_table &kernels() {
+  static const kernel_table table;
+  return table;
+}
+
+constexpr size_t words_for(size_t n) { return (n + state_set::word_bits - 1) / state_set::word_bits; }
+}
+
+void state_set::iterator::seek() {
+  if(idx >= limit) { idx = limit; return; }
+
+  size_t w = idx / word_bits;
+  word curr = bits[w] & (~word{0} << (idx % word_bits));
+  const size_t words = words_for(limit);
+  while(curr == 0) {
+    if(++w == words) { idx = limit; return; }
+    curr = bits[w];
+  }
+  idx = std::min(limit, w * word_bits + (size_t)__builtin_ctzll(curr));
+}
+
+state_set::state_set(size_t size, bool value) : n{size}, bits(words_for(size), value ? ~word{0} : word{0}) {
+  trim();
+}
+
+state_set::state_set(std::span<const word> words, size_t size) : n{size}, bits(words_for(size), 0) {
+  std::copy_n(words.begin(), std::min(words.size(), bits.size()), bits.begin());
+  trim();
+}
+
+void state_set::resize(size_t size) {
+  n = size;
+  bits.resize(words_for(size), 0);
+  trim();
+}
+
+void state_set::clear() {
+  std::fill(bits.begin(), bits.end(), 0);
+}
+
+bool state_set::empty() const {
+  return !kernels().any_w(bits.data(), bits.size());
+}
+
+size_t state_set::count() const {
+  return kernels().count_w(bits.data(), bits.size());
+}
+
+bool state_set::intersects(const state_set &other) const {
+  return kernels().intersects_w(bits.data(), other.bits.data(), std::min(bits.size(), other.bits.size()));
+}
+
+bool state_set::intersects(std::span<const word> other) const {
+  return kernels().intersects_w(bits.data(), other.data(), std::min(bits.size(), other.size()));
+}
+
+void state_set::unite(std::span<const word> other) {
+  kernels().or_w(bits.data(), other.data(), std::min(bits.size(), other.size()));
+  trim();
+}
+
+void state_set::flip() {
+  kernels().not_w(bits.data(), bits.size());
+  trim();
+}
+
+state_set &state_set::operator&=(const state_set &other) {
+  const size_t common = std::min(bits.size(), other.bits.size());
+  kernels().and_w(bits.data(), other.bits.data(), common);
+  std::fill(bits.begin() + (ptrdiff_t)common, bits.end(), 0);
+  return *this;
+}
+
+state_set &state_set::operator|=(const state_set &other) {
+  kernels().or_w(bits.data(), other.bits.data(), std::min(bits.size(), other.bits.size()));
+  trim();
+  return *this;
+}
+
+state_set &state_set::operator-=(const state_set &other) {
+  kernels().andnot_w(bits.data(), other.bits.data(), std::min(bits.size(), other.bits.size()));
+  return *this;
+}
+
+bool state_set::operator==(const state_set &other) const {
+  return n == other.n && bits == other.bits;
+}
+
+void state_set::trim() {
+  if(n % word_bits != 0) bits.back() &= (word{1} << (n % word_bits)) - 1;
+}
+
+state_set ctl::graph::operator&(state_set one, const state_set &other) { return one &= other; }
+state_set ctl::graph::operator|(state_set one, const state_set &other) { return one |= other; }
+state_set ctl::graph::operator-(state_set one, const state_set &other) { return one -= other; }
+state_set ctl::graph::operator~(state_set one) { one.flip(); return one; }
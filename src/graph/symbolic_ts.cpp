@@ -0,0 +1,119 @@
+//
+// Created by jay on 7/25/23.
+//
+
+#include "graph/symbolic_ts.hpp"
+
+using namespace ctl::graph;
+
+symbolic_ts::symbolic_ts(bdd::manager &mgr, size_t bits) : mgr{&mgr}, nbits{bits} {
+  const bdd::var_t base = (bdd::var_t)mgr.var_count();
+  for(size_t i = 0; i < 2 * bits; i++) mgr.new_var();
+
+  to_next.resize(base + 2 * bits);
+  to_cur.resize(base + 2 * bits);
+  for(size_t i = 0; i < bits; i++) {
+    const auto c = (bdd::var_t)(base + 2 * i), n = (bdd::var_t)(c + 1);
+    cur_vars.push_back(c);
+    next_vars.push_back(n);
+    to_next[c] = to_cur[c] = n;
+    to_next[n] = to_cur[n] = c;
+  }
+
+  cur_cube = mgr.cube(cur_vars);
+  next_cube = mgr.cube(next_vars);
+  init = mgr.zero();
+  trans = mgr.zero();
+  valid = mgr.one();
+}
+
+symbolic_ts::set_t symbolic_ts::cur(size_t bit) const {
+  return mgr->var(cur_vars[bit]);
+}
+
+symbolic_ts::set_t symbolic_ts::next(size_t bit) const {
+  return mgr->var(next_vars[bit]);
+}
+
+symbolic_ts::set_t symbolic_ts::encode(std::uint64_t code, bool primed) const {
+  const auto &vs = primed ? next_vars : cur_vars;
+  set_t res = mgr->one();
+  for(size_t i = nbits; i-- > 0;) {
+    const size_t shift = nbits - 1 - i;
+    const bool bit = shift < 64 && ((code >> shift) & 1) != 0;
+    res &= bit ? mgr->var(vs[i]) : mgr->nvar(vs[i]);
+  }
+  return res;
+}
+
+void symbolic_ts::add_initial(const set_t &states) {
+  init |= states & valid;
+}
+
+void symbolic_ts::add_transitions(const set_t &rel) {
+  trans |= rel & valid & mgr->replace(valid, to_next);
+}
+
+void symbolic_ts::add_label(const prop &p, const set_t &states) {
+  auto it = labels.find(p);
+  if(it == labels.end()) labels.emplace(p, states & valid);
+  else it->second |= states & valid;
+}
+
+void symbolic_ts::restrict_states(const set_t &states) {
+  valid &= states;
+  init &= valid;
+  trans &= valid & mgr->replace(valid, to_next);
+  for(auto &[_, l]: labels) l &= valid;
+}
+
+symbolic_ts::set_t symbolic_ts::label(const prop &p) const {
+  auto it = labels.find(p);
+  return it == labels.end() ? mgr->zero() : it->second;
+}
+
+symbolic_ts::set_t symbolic_ts::pre_image(const set_t &s) const {
+  return mgr->and_exists(trans, mgr->replace(s, to_next), next_cube);
+}
+
+symbolic_ts::set_t symbolic_ts::post_image(const set_t &s) const {
+  return mgr->replace(mgr->and_exists(trans, s, cur_cube), to_cur);
+}
+
+double symbolic_ts::count(const set_t &s) const {
+  return mgr->sat_count(s, cur_vars);
+}
+
+bool symbolic_ts::contains(const set_t &s, std::uint64_t code) const {
+  std::vector<bool> assignment(mgr->var_count(), false);
+  for(size_t i = 0; i < nbits; i++) {
+    const size_t shift = nbits - 1 - i;
+    if(shift < 64) assignment[cur_vars[i]] = ((code >> shift) & 1) != 0;
+  }
+  return mgr->eval(s, assignment);
+}
+
+symbolic_ts::set_t symbolic_ts::disjunction(std::vector<set_t> parts) const {
+  if(parts.empty()) return mgr->zero();
+  while(parts.size() > 1) {
+    size_t out = 0;
+    for(size_t i = 0; i + 1 < parts.size(); i += 2) parts[out++] = parts[i] | parts[i + 1];
+    if(parts.size() % 2 == 1) parts[out++] = std::move(parts.back());
+    parts.resize(out);
+  }
+  return parts[0];
+}
+
+symbolic_ts::set_t symbolic_ts::codes_below(std::uint64_t n) const {
+  if(nbits < 64 && n >= (std::uint64_t{1} << nbits)) return mgr->one();
+
+  // built from the least significant bit upwards: below(n) = !x_k \/ below(n mod 2^k) if bit k of n is set,
+  // and !x_k /\ below(n mod 2^k) otherwise
+  set_t res = mgr->zero();
+  for(size_t i = nbits; i-- > 0;) {
+    const size_t shift = nbits - 1 - i;
+    const bool bit = shift < 64 && ((n >> shift) & 1) != 0;
+    res = bit ? (mgr->nvar(cur_vars[i]) | res) : (mgr->nvar(cur_vars[i]) & res);
+  }
+  return res;
+}
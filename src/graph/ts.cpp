@@ -4,84 +4,220 @@
 
 #include <algorithm>
 #include <iostream>
+#include <stdexcept>
+#include <atomic>
 #include "graph/ts.hpp"
+#include "thread_pool.hpp"
 
+using namespace ctl;
 using namespace ctl::graph;
 
-std::vector<const sparse_ts::node *> sparse_ts::node::post_in(const sparse_ts &ts) const {
-  std::vector<const sparse_ts::node *> res;
-  for(const auto &next: transitions) {
-    res.push_back(&ts.nodes[next]);
+namespace {
+constexpr size_t min_chunk = 1 << 14;
+
+void check_capacity(size_t states) {
+  if(states >= max_states) throw std::length_error("Transition system exceeds " + std::to_string(max_states) + " states");
+}
+
+// Calls fn(first, last) on consecutive ranges covering [0, count), spread over the pool if there is one.
+template <typename F>
+void for_ranges(thread_pool *pool, size_t count, F &&fn) {
+  if(pool == nullptr || pool->size() == 1 || count <= min_chunk) {
+    fn(0, count);
+    return;
   }
-  return res;
+  const size_t cs = std::max(min_chunk, count / (pool->size() * 8) + 1);
+  pool->parallel_for((count + cs - 1) / cs, [&](size_t c) { fn(c * cs, std::min(count, (c + 1) * cs)); });
 }
 
-std::vector<const sparse_ts::node *> sparse_ts::node::pre_in(const sparse_ts &ts) const {
-  std::vector<const sparse_ts::node *> res;
-  for(const auto &next: incoming_transitions) {
-    res.push_back(&ts.nodes[next]);
+/*
+ * Lays out the edges as CSR arrays over n rows: row key(e) lists value(e) for every edge e, ascending and without
+ * duplicates. The edges are scattered into their rows by a counting pass (a bucket sort on the key), after which every
+ * row is sorted and deduplicated on its own, so only the rows themselves are ever sorted.
+ */
+template <typename Key, typename Value>
+void build_csr(const std::vector<std::pair<state_id, state_id>> &edges, size_t n, Key &&key, Value &&value,
+               thread_pool *pool, std::vector<size_t> &offsets, std::vector<state_id> &targets) {
+  // cursor[k + 1]: size of row k; after the prefix sum cursor[k] is where row k starts
+  std::vector<size_t> cursor(n + 1, 0);
+  for_ranges(pool, edges.size(), [&](size_t first, size_t last) {
+    for(size_t i = first; i < last; i++) {
+      std::atomic_ref<size_t>(cursor[key(edges[i]) + 1]).fetch_add(1, std::memory_order_relaxed);
+    }
+  });
+  for(size_t k = 0; k < n; k++) cursor[k + 1] += cursor[k];
+
+  offsets.assign(cursor.begin(), cursor.end());
+  targets.resize(edges.size());
+  for_ranges(pool, edges.size(), [&](size_t first, size_t last) {
+    for(size_t i = first; i < last; i++) {
+      const size_t at = std::atomic_ref<size_t>(cursor[key(edges[i])]).fetch_add(1, std::memory_order_relaxed);
+      targets[at] = value(edges[i]);
+    }
+  });
+
+  // cursor[k] is now the end of row k; it becomes the deduplicated length of row k
+  for_ranges(pool, n, [&](size_t first, size_t last) {
+    for(size_t k = first; k < last; k++) {
+      auto *row = targets.data() + offsets[k];
+      auto *end = targets.data() + cursor[k];
+      std::sort(row, end);
+      cursor[k] = std::unique(row, end) - row;
+    }
+  });
+
+  size_t kept = 0;
+  for(size_t k = 0; k < n; k++) kept += cursor[k];
+  if(kept == edges.size()) return;
+
+  // drop the duplicates: rows only ever move to the left, so this can be done in place (in order); rows that stay put
+  // are skipped, as std::copy may not write into its own source range
+  size_t out = 0;
+  for(size_t k = 0; k < n; k++) {
+    const size_t begin = offsets[k];
+    if(out != begin) {
+      std::copy(targets.begin() + (ptrdiff_t)begin, targets.begin() + (ptrdiff_t)(begin + cursor[k]), targets.begin() + (ptrdiff_t)out);
+    }
+    offsets[k] = out;
+    out += cursor[k];
   }
-  return res;
+  offsets[n] = out;
+  targets.resize(out);
+  targets.shrink_to_fit();
+}
 }
 
-size_t sparse_ts::add(std::string &&name, std::unordered_set<prop> &&ap, bool is_initial, bool is_accepting) {
-  nodes.emplace_back(std::move(name), std::move(ap));
+size_t sparse_ts::add(std::string_view name, std::unordered_set<prop> &&ap, bool is_initial, bool is_accepting) {
+  check_capacity(nodes.size());
+  thaw();
+  names.add(name);
+  nodes.emplace_back(nodes.size());
+  for(const auto &p: ap) labels.add(nodes.size() - 1, p);
   if(is_initial) initial_states.insert(nodes.size() - 1);
   if(is_accepting) accepting_states.insert(nodes.size() - 1);
   return nodes.size() - 1;
 }
 
 void sparse_ts::add_transition(size_t start, size_t end) {
+  thaw();
   auto &r = nodes[start].transitions;
   if(std::find(r.begin(), r.end(), end) == r.end()) {
-    r.push_back(end);
-    nodes[end].incoming_transitions.push_back(start);
+    r.push_back((state_id)end);
+    nodes[end].incoming_transitions.push_back((state_id)start);
   }
 }
 
-std::vector<const dense_ts::node *> dense_ts::node::pre_in(const dense_ts &ts) const {
-  std::vector<const dense_ts::node *> res;
-  for(size_t i = 0; i < ts.transitions.size(); i++) {
-    if(ts.transitions[i][idx]) res.push_back(&ts.nodes[i]);
+void sparse_ts::remove_transition(size_t start, size_t end) {
+  if(!raw_edges.empty()) freeze();
+  thaw();
+  auto &r = nodes[start].transitions;
+  auto it = std::find(r.begin(), r.end(), end);
+  if(it == r.end()) return;
+  r.erase(it);
+  auto &in = nodes[end].incoming_transitions;
+  in.erase(std::find(in.begin(), in.end(), start));
+}
+
+void sparse_ts::freeze(thread_pool *pool) {
+  if(is_frozen && raw_edges.empty()) return;
+
+  // the edges already in the TS are simply rebuilt along with the queued ones
+  size_t existing = fwd_targets.size();
+  for(const auto &nd: nodes) existing += nd.transitions.size();
+  raw_edges.reserve(raw_edges.size() + existing);
+  for(size_t i = 0; i < nodes.size(); i++) {
+    for(const auto t: nodes[i].successors(*this)) raw_edges.emplace_back((state_id)i, t);
+    std::vector<state_id>{}.swap(nodes[i].transitions);
+    std::vector<state_id>{}.swap(nodes[i].incoming_transitions);
   }
-  return res;
+
+  const size_t n = nodes.size();
+  build_csr(raw_edges, n, [](const auto &e) { return e.first; }, [](const auto &e) { return e.second; }, pool,
+            fwd_offsets, fwd_targets);
+  build_csr(raw_edges, n, [](const auto &e) { return e.second; }, [](const auto &e) { return e.first; }, pool,
+            bwd_offsets, bwd_targets);
+  std::vector<std::pair<state_id, state_id>>{}.swap(raw_edges);
+  is_frozen = true;
 }
 
-std::vector<const dense_ts::node *> dense_ts::node::post_in(const dense_ts &ts) const {
-  std::vector<const dense_ts::node *> res;
-  auto &ref = ts.transitions[idx];
-  for(size_t i = 0; i < ref.size(); i++) {
-    if(ref[i]) res.push_back(&ts.nodes[i]);
+void sparse_ts::thaw() {
+  if(!is_frozen) return;
+
+  for(size_t i = 0; i < nodes.size(); i++) {
+    auto succ = nodes[i].successors(*this);
+    auto pred = nodes[i].predecessors(*this);
+    nodes[i].transitions.assign(succ.begin(), succ.end());
+    nodes[i].incoming_transitions.assign(pred.begin(), pred.end());
   }
-  return res;
+
+  std::vector<size_t>{}.swap(fwd_offsets);
+  std::vector<state_id>{}.swap(fwd_targets);
+  std::vector<size_t>{}.swap(bwd_offsets);
+  std::vector<state_id>{}.swap(bwd_targets);
+  is_frozen = false;
 }
 
-size_t dense_ts::add(std::string &&name, std::unordered_set<prop> &&ap, bool is_initial, bool is_accepting) {
-  nodes.emplace_back(std::move(name), std::move(ap), nodes.size());
-  for(auto &v: transitions) { v.push_back(false); }
-  transitions.emplace_back();
-  transitions.back().resize(transitions.size(), false);
+void dense_ts::reserve(size_t states) {
+  nodes.reserve(states);
+  names.reserve(states, 0);
+  fwd.reserve(states);
+  bwd.reserve(states);
+}
+
+size_t dense_ts::add(std::string_view name, std::unordered_set<prop> &&ap, bool is_initial, bool is_accepting) {
+  check_capacity(nodes.size());
+  names.add(name);
+  nodes.emplace_back(nodes.size());
+  for(const auto &p: ap) labels.add(nodes.size() - 1, p);
+  fwd.grow(nodes.size());
+  bwd.grow(nodes.size());
   if(is_initial) initial_states.insert(nodes.size() - 1);
   if(is_accepting) accepting_states.insert(nodes.size() - 1);
   return nodes.size() - 1;
 }
 
 void dense_ts::add_transition(size_t start, size_t end) {
-  transitions[start][end] = true;
+  fwd.set(start, end);
+  bwd.set(end, start);
+}
+
+state_set dense_ts::pre_image(const state_set &s) const {
+  return image(fwd, bwd, s);
+}
+
+state_set dense_ts::post_image(const state_set &s) const {
+  return image(bwd, fwd, s);
+}
+
+state_set dense_ts::image(const bit_matrix &m, const bit_matrix &t, const state_set &s) const {
+  const size_t n = nodes.size();
+  state_set res(n);
+  // a row union costs |s| row operations, the intersection tests at most n (and usually stop early)
+  if(s.count() * 8 <= n) {
+    for(const auto j: s) {
+      if(j < n) res.unite(t.row(j));
+    }
+  }
+  else {
+    for(size_t i = 0; i < n; i++) {
+      if(s.intersects(m.row(i))) res.insert(i);
+    }
+  }
+  return res;
 }
 
 dense_ts sparse_ts::make_dense() const {
   dense_ts res;
+  res.reserve(nodes.size());
 
   for(size_t i = 0; i < nodes.size(); i++) {
-    const auto &n = nodes[i];
-    auto name = n.name();
-    auto prop = n.props();
-    res.add(std::move(name), std::move(prop), initial_states.contains(i), accepting_states.contains(i));
+    std::unordered_set<prop> prop;
+    for(const auto id: labels.of(i)) prop.insert(labels.table().name(id));
+    res.add(names[i], std::move(prop), initial_states.contains(i), accepting_states.contains(i));
   }
 
   for(size_t i = 0; i < nodes.size(); i++) {
-    for(auto &sub: nodes[i].transitions) {
+    for(auto sub: nodes[i].successors(*this)) {
       res.add_transition(i, sub);
     }
   }
@@ -93,18 +229,16 @@ sparse_ts dense_ts::make_sparse() const {
   sparse_ts res;
 
   for(size_t i = 0; i < nodes.size(); i++) {
-    const auto &n = nodes[i];
-    auto name = n.name();
-    auto prop = n.props();
-    res.add(std::move(name), std::move(prop), initial_states.contains(i), accepting_states.contains(i));
+    std::unordered_set<prop> prop;
+    for(const auto id: labels.of(i)) prop.insert(labels.table().name(id));
+    res.add(names[i], std::move(prop), initial_states.contains(i), accepting_states.contains(i));
   }
 
-  for(size_t i = 0; i < transitions.size(); i++) {
-    for(size_t j = 0; j < transitions[i].size(); j++) {
-      res.add_transition(i, j);
-    }
+  for(size_t i = 0; i < nodes.size(); i++) {
+    for(const auto j: successors(i)) res.add_edge(i, j);
   }
 
+  res.freeze();
   return res;
 }
 
@@ -112,10 +246,10 @@ void sparse_ts::dump() const {
   std::cout << " --- Sparse TS with " << nodes.size() << " nodes ---\n";
   for(size_t i = 0; i < nodes.size(); i++) {
     const auto &n = nodes[i];
-    std::cout << "  -> Node `" << n.name() << "'.\n";
+    std::cout << "  -> Node `" << names[i] << "'.\n";
     std::cout << "    + Atomic propositions:";
-    for(const auto &prop: n.props()) {
-      std::cout << " " << prop;
+    for(const auto id: labels.of(i)) {
+      std::cout << " " << labels.table().name(id);
     }
     std::cout << "\n";
     if(initial_states.contains(i)) {
@@ -124,16 +258,15 @@ void sparse_ts::dump() const {
     if(accepting_states.contains(i)) {
       std::cout << "    + Accepting state\n";
     }
-    if(n.transitions.empty()) {
+    if(n.successors(*this).empty()) {
       std::cout << "    + No successors\n";
     }
     else {
       std::cout << "    + Successors: \n";
-      for (const auto &j: n.transitions) {
-        const auto &n2 = nodes[j];
-        std::cout << "      ~> " << n2.name() << "; propositions:";
-        for (const auto &p: n2.props()) {
-          std::cout << " " << p;
+      for (const auto &j: n.successors(*this)) {
+        std::cout << "      ~> " << names[j] << "; propositions:";
+        for (const auto id: labels.of(j)) {
+          std::cout << " " << labels.table().name(id);
         }
         std::cout << "\n";
       }
@@ -144,11 +277,10 @@ void sparse_ts::dump() const {
 void dense_ts::dump() const {
   std::cout << " --- Dense TS with " << nodes.size() << " nodes ---\n";
   for(size_t i = 0; i < nodes.size(); i++) {
-    const auto &n = nodes[i];
-    std::cout << "  -> Node `" << n.name() << "'.\n";
+    std::cout << "  -> Node `" << names[i] << "'.\n";
     std::cout << "    + Atomic propositions:";
-    for(const auto &prop: n.props()) {
-      std::cout << " " << prop;
+    for(const auto id: labels.of(i)) {
+      std::cout << " " << labels.table().name(id);
     }
     std::cout << "\n";
     if(initial_states.contains(i)) {
@@ -157,33 +289,18 @@ void dense_ts::dump() const {
     if(accepting_states.contains(i)) {
       std::cout << "    + Accepting state\n";
     }
-    if(std::all_of(transitions[i].begin(), transitions[i].end(), [](bool b){ return !b; })) {
+    if(successors(i).begin() == successors(i).end()) {
       std::cout << "    + No successors\n";
     }
     else {
       std::cout << "    + Successors: \n";
-      for (size_t j = 0; j < transitions[i].size(); j++) {
-        if(transitions[i][j]) {
-          const auto &n2 = nodes[j];
-          std::cout << "      ~> " << n2.name() << "; propositions:";
-          for (const auto &p: n2.props()) {
-            std::cout << " " << p;
-          }
-          std::cout << "\n";
+      for (const auto j: successors(i)) {
+        std::cout << "      ~> " << names[j] << "; propositions:";
+        for (const auto id: labels.of(j)) {
+          std::cout << " " << labels.table().name(id);
         }
+        std::cout << "\n";
       }
     }
   }
 }
-
-std::unordered_set<const sparse_ts::node *> sparse_ts::initial_nodes() const {
-  std::unordered_set<const sparse_ts::node *> res;
-  for(const auto &i: initial_states) res.insert(&nodes[i]);
-  return res;
-}
-
-std::unordered_set<const dense_ts::node *> dense_ts::initial_nodes() const {
-  std::unordered_set<const dense_ts::node *> res;
-  for(const auto &i: initial_states) res.insert(&nodes[i]);
-  return res;
-}
\ No newline at end of file
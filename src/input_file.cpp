@@ -0,0 +1,47 @@
+//
+// Created by jay on 8/7/23.
+//
+
+#include <cerrno>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "input_file.hpp"
+
+using namespace ctl;
+
+input_file::input_file(const std::string &path) {
+  fd = open(path.c_str(), O_RDONLY);
+  if(fd < 0) throw std::runtime_error("can't open file " + path + " for reading");
+
+  struct stat st{};
+  if(fstat(fd, &st) != 0) {
+    close(fd);
+    throw std::runtime_error("can't stat file " + path);
+  }
+  len = (std::uint64_t)st.st_size;
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+}
+
+input_file::~input_file() {
+  close(fd);
+}
+
+void input_file::read(void *dst, std::uint64_t bytes, std::uint64_t offset) const {
+  auto *out = (char *)dst;
+  while(bytes > 0) {
+    const ssize_t got = pread(fd, out, bytes, (off_t)offset);
+    if(got < 0 && errno == EINTR) continue;
+    if(got < 0) throw std::runtime_error("read failed");
+    if(got == 0) throw std::runtime_error("unexpected end of file");
+    out += got;
+    offset += (std::uint64_t)got;
+    bytes -= (std::uint64_t)got;
+    total += (std::uint64_t)got;
+  }
+}
+
+void input_file::will_need(std::uint64_t offset, std::uint64_t bytes) const {
+  posix_fadvise(fd, (off_t)offset, (off_t)bytes, POSIX_FADV_WILLNEED);
+}
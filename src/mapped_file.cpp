@@ -0,0 +1,39 @@
+//
+// Created by jay on 7/26/23.
+//
+
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "mapped_file.hpp"
+
+using namespace ctl;
+
+mapped_file::mapped_file(const std::string &path) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if(fd < 0) throw std::runtime_error("can't open file " + path + " for reading");
+
+  struct stat st{};
+  if(fstat(fd, &st) != 0) {
+    close(fd);
+    throw std::runtime_error("can't stat file " + path);
+  }
+
+  len = (size_t)st.st_size;
+  if(len != 0) {
+    void *map = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(map == MAP_FAILED) {
+      close(fd);
+      throw std::runtime_error("can't map file " + path);
+    }
+    madvise(map, len, MADV_SEQUENTIAL);
+    ptr = (const char *)map;
+  }
+  close(fd);
+}
+
+mapped_file::~mapped_file() {
+  if(ptr != nullptr) munmap((void *)ptr, len);
+}
@@ -0,0 +1,62 @@
+//
+// Created by jay on 7/18/23.
+//
+
+#include "thread_pool.hpp"
+
+using namespace ctl;
+
+thread_pool::thread_pool(size_t threads) {
+  for(size_t i = 1; i < threads; i++) {
+    workers.emplace_back([this]() { work(); });
+  }
+}
+
+thread_pool::~thread_pool() {
+  {
+    std::lock_guard lock(mtx);
+    stopping = true;
+  }
+  cv.notify_all();
+  for(auto &w: workers) w.join();
+}
+
+void thread_pool::submit(std::function<void()> task) {
+  {
+    std::lock_guard lock(mtx);
+    tasks.push_back(std::move(task));
+  }
+  cv.notify_one();
+}
+
+void thread_pool::wake() {
+  {
+    std::lock_guard lock(mtx);
+  }
+  cv.notify_all();
+}
+
+void thread_pool::work() {
+  while(true) {
+    std::function<void()> task;
+    {
+      std::unique_lock lock(mtx);
+      cv.wait(lock, [this]() { return stopping || !tasks.empty(); });
+      if(tasks.empty()) return;
+      task = std::move(tasks.front());
+      tasks.pop_front();
+    }
+    task();
+  }
+}
+
+void thread_pool::participate(loop_state &state, size_t self) {
+  const size_t participants = state.ranges.size();
+  for(size_t offset = 0; offset < participants; offset++) {
+    auto &r = state.ranges[(self + offset) % participants];
+    for(size_t i = r.next.fetch_add(1); i < r.end; i = r.next.fetch_add(1)) {
+      state.fn(i);
+      if(state.remaining.fetch_sub(1) == 1) state.remaining.notify_all();
+    }
+  }
+}